@@ -0,0 +1,203 @@
+/* -----------------------------------------------------------------------------
+   Letter-count signatures for LAMPFlash.
+
+   The tests on whole signatures all work the same way.  Setting the
+   spare top bit of every nibble of x and subtracting y, where no count
+   is over seven, leaves 8 + x - y in each nibble with no borrows - the
+   top bit still set where x has at least as many of that letter as y,
+   and the three bits under it the difference.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "anagram.h"
+
+
+/* The top bit of every nibble */
+#define GUARD           0x88888888UL
+
+#define LETTERSPERWORD  7
+
+#define ROTL(x, k)      (((x) << (k)) | ((x) >> (32 - (k))))
+
+
+/* Where letter i (0 for A) is counted */
+#define SigWord(i)      ((i) / LETTERSPERWORD)
+#define SigShift(i)     (4 * (LETTERSPERWORD - 1 - (i) % LETTERSPERWORD))
+
+
+
+/* The letters of word (either case) counted into sig.  Returns the
+   number of '?'s (blanks) in it, or -1 if it has anything else that
+   isn't a letter or more than ANAGRAMMAXCOUNT of one letter. */
+Int16 AnagramSig(const Char *word, UInt16 len, anagramSigType *sig)
+{
+  UInt8 counts[26];
+  Int16 blanks = 0;
+  UInt16 i;
+  Char c;
+
+  MemSet(counts, sizeof(counts), 0);
+  for (i = 0; i < len; i++)
+    {
+      c = word[i];
+      if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+	{
+	  if (++counts[(c & 0x1F) - 1] > ANAGRAMMAXCOUNT)
+	    return -1;
+	}
+      else if (c == '?')
+	blanks++;
+      else
+	return -1;
+    }
+
+  sig->s[0] = sig->s[1] = sig->s[2] = sig->s[3] = 0;
+  for (i = 0; i < 26; i++)
+    sig->s[SigWord(i)] |= (UInt32) counts[i] << SigShift(i);
+
+  return blanks;
+}
+
+
+
+/* Sum of the nibbles of x */
+static UInt16 NibbleSum(UInt32 x)
+{
+  x = (x & 0x0F0F0F0FUL) + ((x >> 4) & 0x0F0F0F0FUL);
+  x += x >> 8;
+  x += x >> 16;
+
+  return x & 0xFF;
+}
+
+
+
+/* Each nibble of x less the same nibble of y, or zero if that would be
+   below zero */
+static UInt32 Less(UInt32 x, UInt32 y)
+{
+  UInt32 d = (x | GUARD) - y;
+  UInt32 keep = d & GUARD;
+
+  return d & ((keep >> 1) | (keep >> 2) | (keep >> 3));
+}
+
+
+
+/* Number of letters */
+UInt16 AnagramLength(const anagramSigType *sig)
+{
+  return NibbleSum(sig->s[0]) + NibbleSum(sig->s[1])
+    + NibbleSum(sig->s[2]) + NibbleSum(sig->s[3]);
+}
+
+
+
+/* How many letters of word the rack is short of - the blanks it would
+   need to make word */
+UInt16 AnagramShort(const anagramSigType *rack, const anagramSigType *word)
+{
+  return NibbleSum(Less(word->s[0], rack->s[0])) + NibbleSum(Less(word->s[1], rack->s[1]))
+    + NibbleSum(Less(word->s[2], rack->s[2])) + NibbleSum(Less(word->s[3], rack->s[3]));
+}
+
+
+
+/* Can word be made from the letters of rack and that many blanks? */
+Boolean AnagramHolds(const anagramSigType *rack, const anagramSigType *word, UInt16 blanks)
+{
+  /* With no blanks every letter's guard bit has to survive */
+  if (blanks == 0)
+    return (((rack->s[0] | GUARD) - word->s[0]) & ((rack->s[1] | GUARD) - word->s[1])
+	    & ((rack->s[2] | GUARD) - word->s[2]) & ((rack->s[3] | GUARD) - word->s[3])
+	    & GUARD) == GUARD;
+
+  return AnagramShort(rack, word) <= blanks;
+}
+
+
+
+/* Take the letters of word off rack, as far as the rack has them */
+void AnagramTake(anagramSigType *rack, const anagramSigType *word)
+{
+  UInt16 i;
+
+  for (i = 0; i < 4; i++)
+    rack->s[i] = Less(rack->s[i], word->s[i]);
+}
+
+
+
+/* Order of a and b - for words of one length, the order of their
+   alphagrams */
+Int16 AnagramCompare(const anagramSigType *a, const anagramSigType *b)
+{
+  UInt16 i;
+
+  for (i = 0; i < 4; i++)
+    if (a->s[i] != b->s[i])
+      return (a->s[i] > b->s[i]) ? -1 : 1;
+
+  return 0;
+}
+
+
+
+UInt32 AnagramHash(const anagramSigType *sig)
+{
+  UInt32 h = sig->s[0];
+
+  h = ROTL(h, 7) ^ sig->s[1];
+  h = ROTL(h, 7) ^ sig->s[2];
+  h = ROTL(h, 7) ^ sig->s[3];
+
+  /* Spread the counts over all the bits */
+  h ^= h >> 15;
+  h += h << 11;
+  h ^= h >> 7;
+  h += h << 5;
+  h ^= h >> 16;
+
+  return h;
+}
+
+
+
+/* The letters of sig in order (uppercase), terminated, in out.  Returns
+   how many there are. */
+UInt16 AnagramAlphagram(const anagramSigType *sig, Char *out)
+{
+  UInt16 i, n, len = 0;
+
+  for (i = 0; i < 26; i++)
+    for (n = (sig->s[SigWord(i)] >> SigShift(i)) & 0x0F; n > 0; n--)
+      out[len++] = 'A' + i;
+  out[len] = '\0';
+
+  return len;
+}
+
+
+
+void AnagramPack(const anagramSigType *sig, UInt8 *p)
+{
+  UInt16 i;
+
+  for (i = 0; i < 26; i += 2)
+    *p++ = (((sig->s[SigWord(i)] >> SigShift(i)) & 0x0F) << 4)
+      | ((sig->s[SigWord(i + 1)] >> SigShift(i + 1)) & 0x0F);
+}
+
+
+
+void AnagramUnpack(const UInt8 *p, anagramSigType *sig)
+{
+  UInt16 i;
+
+  sig->s[0] = sig->s[1] = sig->s[2] = sig->s[3] = 0;
+  for (i = 0; i < 26; i += 2, p++)
+    {
+      sig->s[SigWord(i)] |= (UInt32) (*p >> 4) << SigShift(i);
+      sig->s[SigWord(i + 1)] |= (UInt32) (*p & 0x0F) << SigShift(i + 1);
+    }
+}
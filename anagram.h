@@ -0,0 +1,60 @@
+/* Letter-count signatures.
+
+   Two words are anagrams exactly when they have the same number of each
+   letter, so a word's letter counts make a key that needs no sorting to
+   build and no string compare to test.  A signature packs the 26
+   counts into four UInt32s, seven letters to a word and a nibble to a
+   letter, with A in the top nibble of the first word:
+
+       s[0]  .... AAAA BBBB CCCC DDDD EEEE FFFF GGGG
+       s[1]  .... HHHH IIII ...                 NNNN
+       s[2]  .... OOOO ...                      UUUU
+       s[3]  .... .... .... VVVV ...            ZZZZ
+
+   Each count is three bits, so no letter can be in a word more than
+   seven times, and the top bit of each nibble is kept clear.  That spare
+   bit lets a whole UInt32 of counts be subtracted at once without one
+   letter borrowing from the next, which is how a rack is tested for
+   holding a word (and how many blanks it would need) in a handful of
+   operations with no loop over the letters.
+
+   Equal signatures are equal UInt32s.  Compared as numbers, words first,
+   the signatures of words of one length go in the reverse of the order
+   of their alphagrams - more A's sorts first, then more B's and so on -
+   so AnagramCompare() puts them in alphagram order.
+
+   On disk (or in a record) a signature takes ANAGRAMPACKSIZE bytes: two
+   letters to a byte, A in the top nibble of the first.
+
+   None of this needs the Data Manager or a multiply, so it is shared by
+   the Palm and the host tools. */
+
+#ifndef ANAGRAM_H
+#define ANAGRAM_H
+
+/* Most of one letter a signature can count */
+#define ANAGRAMMAXCOUNT    7
+
+#define ANAGRAMPACKSIZE    13
+
+/* anagramSigType - The letter counts of a word or rack */
+typedef struct
+{
+  UInt32        s[4];
+} anagramSigType;
+
+#define AnagramEqual(a, b)  ((a)->s[0] == (b)->s[0] && (a)->s[1] == (b)->s[1] \
+			     && (a)->s[2] == (b)->s[2] && (a)->s[3] == (b)->s[3])
+
+Int16   AnagramSig(const Char *word, UInt16 len, anagramSigType *sig);
+UInt16  AnagramLength(const anagramSigType *sig);
+UInt16  AnagramShort(const anagramSigType *rack, const anagramSigType *word);
+Boolean AnagramHolds(const anagramSigType *rack, const anagramSigType *word, UInt16 blanks);
+void    AnagramTake(anagramSigType *rack, const anagramSigType *word);
+Int16   AnagramCompare(const anagramSigType *a, const anagramSigType *b);
+UInt32  AnagramHash(const anagramSigType *sig);
+UInt16  AnagramAlphagram(const anagramSigType *sig, Char *out);
+void    AnagramPack(const anagramSigType *sig, UInt8 *p);
+void    AnagramUnpack(const UInt8 *p, anagramSigType *sig);
+
+#endif
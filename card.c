@@ -0,0 +1,393 @@
+/* -----------------------------------------------------------------------------
+   Flashcard record parsing for LAMPFlash.
+
+   Binary records are checked and then used in place: the card just
+   points at the strings in the (locked) record.  Text records are
+   parsed into the card's own buffers as they always were, except that
+   nothing now runs past the end of the record or of a buffer - long
+   words are cut short.  A card's arrays are sized to fit its answers,
+   however many there are, and kept for the next card parsed into it so
+   that they're seldom allocated.
+
+   Hooks are only turned back into letters when they are displayed, and
+   the letter a blank stands for is only shown in lowercase then too -
+   the answers of a blank card are kept in uppercase.
+
+   A build-up card isn't read from a record at all: its answers are the
+   words its rack makes, found in the lexicon as the card is shown.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "card.h"
+
+
+static const Char *cardNoWords[1] = { "" };
+
+const cardType cardNone = { 0, "", cardNoWords };
+
+
+/* buildUpType - A build-up card being made.  The answers go longest
+   first, so each length has its own place in the arrays and text. */
+typedef struct
+{
+  cardType     *card;
+  UInt16        n[MAXWORDLENGTH + 1];     /* Words of each length (that fit) */
+  UInt16        next[MAXWORDLENGTH + 1];  /* Where the next of that length goes */
+  UInt16        text[MAXWORDLENGTH + 1];  /* ... and its letters */
+  UInt32        count;
+  UInt32        size;                     /* Bytes of text they take */
+} buildUpType;
+
+
+
+/* Make room in card for n answers and size bytes of text.  What's there
+   already is kept if it's big enough, so it's only the first card or a
+   bigger one than before that allocates anything. */
+static Boolean CardRoom(cardType *card, UInt16 n, UInt16 size)
+{
+  MemPtr p;
+
+  if (!card->words || n > card->room)
+    {
+      /* The arrays are one block, with room for the empty string after
+	 the last answer */
+      p = MemPtrNew((UInt32) (n + 1) * (sizeof(Char *) + 2 * sizeof(UInt32) + 1));
+      if (!p)
+	return false;
+      if (card->words)
+	MemPtrFree((MemPtr) card->words);
+
+      card->words = p;
+      card->front = (UInt32 *) (card->words + n + 1);
+      card->back = card->front + n + 1;
+      card->blank = (Char *) (card->back + n + 1);
+      card->room = n;
+    }
+
+  if (size > card->text.size)
+    {
+      p = MemPtrNew(size);
+      if (!p)
+	return false;
+      if (card->text.words)
+	MemPtrFree(card->text.words);
+
+      card->text.words = p;
+      card->text.size = size;
+    }
+
+  return true;
+}
+
+
+
+/* The card's answers are done: count of them, then the empty string */
+static void CardDone(cardType *card, UInt16 count)
+{
+  card->count = count;
+  card->words[count] = "";
+}
+
+
+
+/* Let go of what card has allocated, leaving it with no answers */
+void CardFree(cardType *card)
+{
+  if (card->words)
+    MemPtrFree((MemPtr) card->words);
+  if (card->text.words)
+    MemPtrFree(card->text.words);
+
+  MemSet(card, sizeof(cardType), 0);
+}
+
+
+
+/* The string at offset off of a binary record, or NULL if it runs off
+   the end of the record or is longer than max */
+static const Char *CardString(const UInt8 *rec, UInt16 size, UInt16 off,
+			      UInt16 max)
+{
+  UInt16 i;
+
+  for (i = off; i < size && i - off <= max; i++)
+    if (rec[i] == '\0')
+      return (const Char *) rec + off;
+
+  return NULL;
+}
+
+
+
+static Boolean CardParseBinary(const UInt8 *rec, UInt32 size, cardType *card)
+{
+  const cardHeaderType *hdr = (const cardHeaderType *) rec;
+  const cardAnswerType *a = (const cardAnswerType *) (hdr + 1);
+  UInt16 i;
+
+  if (hdr->version != CARDVERSION || hdr->size > size
+      || hdr->size < sizeof(cardHeaderType) + hdr->count * sizeof(cardAnswerType))
+    return false;
+
+  size = hdr->size;
+
+  card->question = CardString(rec, size, hdr->question, MAXWORDLENGTH);
+  if (!card->question || !CardRoom(card, hdr->count, 0))
+    return false;
+
+  for (i = 0; i < hdr->count; i++, a++)
+    {
+      card->words[i] = CardString(rec, size, a->word, MAXWORDLENGTH);
+      if (!card->words[i])
+	return false;
+
+      card->front[i] = a->front & HOOKALL;
+      card->back[i] = a->back & HOOKALL;
+      card->blank[i] = (a->blank >= 'A' && a->blank <= 'Z') ? a->blank : 0;
+    }
+
+  CardDone(card, hdr->count);
+  return true;
+}
+
+
+
+/* Read hooks up to the closing '/' into *hooks.  Anything that isn't a
+   letter is ignored.  Returns the input pointer after the '/'. */
+static const Char *CardTextHooks(const Char *t, const Char *end, UInt32 *hooks)
+{
+  *hooks = 0;
+
+  for (; t < end && *t && *t != 47; t++)
+    if ((*t >= 'A' && *t <= 'Z') || (*t >= 'a' && *t <= 'z'))
+      *hooks |= HOOKBIT(*t);
+
+  if (t < end && *t == 47)
+    t++;
+
+  return t;
+}
+
+
+
+static Boolean CardParseText(const Char *t, const Char *end, cardType *card)
+{
+  cardTextType *x = &card->text;
+  UInt16 d = 0;   /* Number of answers read */
+  UInt16 n, max;
+  UInt32 spaces = 0, slashes = 0;
+  const Char *p;
+  Char *w;
+  Boolean blanks;
+
+  /* -- COLLINS update -- */
+
+  /* we could check that each character is alphanumeric but that would probably be overkill
+     afterall that is checked for when creating the databases in the first place.  Probably.
+     This loose checking allows new Collins words - annotated with "+" - to be shown. */
+
+  /* It would be nice to add a Preference that can switch on/off
+     the displaying of "+" characters */
+
+  /* Parse the flashcard question (alphagram) text */
+  for (n = 0; t < end && *t && *t != 9; t++)
+    if (n < MAXWORDLENGTH)
+      x->question[n++] = *t;
+  x->question[n] = '\0';
+  card->question = x->question;
+
+  /* Advance the input pointer beyond the first tab character */
+  if (t < end && *t == 9)
+    t++;
+
+  /* Every answer but the last ends at a space or the last '/' of its
+     hooks, which says how much room the answers could need */
+  for (p = t; p < end && *p; p++)
+    if (*p == 32)
+      spaces++;
+    else if (*p == 47)
+      slashes++;
+  max = spaces + slashes / 3 + 1;
+  if (max > 0x7FFF || (UInt32) (p - t) + max > 0xFFFF || !CardRoom(card, max, (p - t) + max))
+    return false;
+
+  /* A blank card's answers have the blank's letter in lowercase */
+  blanks = StrChr(x->question, '?') != NULL;
+
+  /* get the ANSWERS and hooks */
+  for (w = x->words; t < end && *t && d < max; w += n + 1)
+    {
+      /* exists and is not SPACE or '/' */
+      card->blank[d] = 0;
+      for (n = 0; t < end && *t && *t != 47 && *t != 32; t++)
+	if (n < MAXWORDLENGTH)
+	  {
+	    w[n] = *t;
+	    if (blanks && *t >= 'a' && *t <= 'z')
+	      w[n] = card->blank[d] = *t - 32;
+	    n++;
+	  }
+      w[n] = '\0';
+
+      card->front[d] = 0;
+      card->back[d] = 0;
+
+      if (t < end && *t == 47) /* found a '/' - get the FRONT and BACK hooks */
+	{
+	  t = CardTextHooks(t + 1, end, &card->front[d]);
+	  t = CardTextHooks(t, end, &card->back[d]);
+	}
+      else if (t < end && *t == 32)
+	t++;
+
+      card->words[d] = w;
+      d++;    /* increase the ANSWERS count */
+    }
+
+  CardDone(card, d);
+  return true;
+}
+
+
+
+/* Is the record rec of size bytes in the binary format? */
+Boolean CardIsBinary(const void *rec, UInt32 size)
+{
+  return (size >= sizeof(cardHeaderType) && *(const UInt8 *) rec == CARDMAGIC);
+}
+
+
+
+/* Parse the record rec of size bytes into card.  A binary card points
+   into rec so the record must stay locked while the card is in use.
+   Returns false if the record is damaged. */
+Boolean CardParse(const void *rec, UInt32 size, cardType *card)
+{
+  if (CardIsBinary(rec, size))
+    return CardParseBinary(rec, size, card);
+
+  return CardParseText(rec, (const Char *) rec + size, card);
+}
+
+
+
+/* Count a word of a build-up card */
+static Boolean CardBuildUpCount(void *ctx, const Char *word, UInt16 len)
+{
+  buildUpType *b = ctx;
+
+  if (len <= MAXWORDLENGTH)
+    {
+      b->n[len]++;
+      b->count++;
+      b->size += len + 1;
+    }
+
+  return true;
+}
+
+
+
+/* Put a word of a build-up card in its place, in uppercase, noting the
+   letter a blank stands for (the last, if there are two) */
+static Boolean CardBuildUpWord(void *ctx, const Char *word, UInt16 len)
+{
+  buildUpType *b = ctx;
+  cardType *card = b->card;
+  Char *w;
+  UInt16 i, d;
+
+  if (len > MAXWORDLENGTH || b->n[len] == 0)
+    return true;
+
+  b->n[len]--;
+  d = b->next[len]++;
+  w = card->text.words + b->text[len];
+  b->text[len] += len + 1;
+
+  card->blank[d] = 0;
+  for (i = 0; i < len; i++)
+    {
+      w[i] = word[i];
+      if (w[i] >= 'a' && w[i] <= 'z')
+	w[i] = card->blank[d] = w[i] - 32;
+    }
+  w[len] = '\0';
+
+  card->words[d] = w;
+  card->front[d] = 0;
+  card->back[d] = 0;
+
+  return true;
+}
+
+
+
+/* Make card the build-up card of rack: every word of minlen letters or
+   more in d that rack makes ('?' being a blank), longest first and in
+   alphabetical order within a length.  The lexicon is gone through
+   twice - once to count the words, so that the card can be made room
+   for, and once to put them in their places.  A rack with two blanks
+   can make more words than one chunk holds; then the shortest that
+   don't fit are left off.  Returns how many words the card has - 0 if
+   none, or rack isn't a rack. */
+UInt16 CardBuildUp(const dawgType *d, const Char *rack, UInt16 minlen, cardType *card)
+{
+  buildUpType b;
+  UInt16 i, len = StrLen(rack), at = 0, text = 0;
+  UInt16 fit;
+
+  if (len > MAXWORDLENGTH)
+    return 0;
+
+  MemSet(&b, sizeof(b), 0);
+  b.card = card;
+  if (!DawgAnagrams(d, rack, len, minlen, CardBuildUpCount, &b) || b.count == 0)
+    return 0;
+
+  for (i = MAXWORDLENGTH; i > 0; i--)
+    {
+      /* However many of this length fit after the longer ones */
+      fit = b.n[i];
+      if (fit > BUILDUPMAXWORDS - at)
+	fit = BUILDUPMAXWORDS - at;
+      if (fit > (0xFFFF - text) / (i + 1))
+	fit = (0xFFFF - text) / (i + 1);
+      b.n[i] = fit;
+
+      b.next[i] = at;
+      b.text[i] = text;
+      at += fit;
+      text += fit * (i + 1);
+    }
+
+  if (!CardRoom(card, at, text))
+    return 0;
+
+  StrCopy(card->text.question, rack);
+  card->question = card->text.question;
+
+  DawgAnagrams(d, rack, len, minlen, CardBuildUpWord, &b);
+  CardDone(card, at);
+
+  return at;
+}
+
+
+
+/* Write the letters of hooks to s in lowercase, in alphabetical order,
+   and terminate it.  s needs room for MAXNOHOOKS + 1.  Returns the
+   number of letters written. */
+UInt16 CardHookString(UInt32 hooks, Char *s)
+{
+  Char *p = s;
+  Char c = 'a';
+
+  for (; hooks; hooks >>= 1, c++)
+    if (hooks & 1)
+      *p++ = c;
+  *p = '\0';
+
+  return p - s;
+}
@@ -0,0 +1,109 @@
+/* Flashcard records.
+
+   A text record of a flashcard DB is the question, a tab, and then the
+   answers separated by spaces.  An answer may carry its hooks as
+   ANSWER/FRONT/BACK/ in which case no space follows it.
+
+   Hooks are kept as a set of letters, one bit per letter with A as bit
+   0, so the front and back hooks of an answer are a UInt32 each.
+
+   A binary record is a cardHeaderType followed by a cardAnswerType for
+   each answer and then the strings they point to, each terminated by a
+   NULL.  Offsets are from the start of the record and all fields are
+   in 68k (big-endian) order.  A binary record is read where it lies so
+   nothing needs copying or scanning.  Which kind a record is is told by
+   its first byte, so a DB can mix the two.
+
+   A blank card's question has a '?' in it for the blank.  Each answer
+   says which letter the blank stands for - in a binary record in its
+   blank field, and in a text record by having that letter in lowercase
+   ("AEINRT?\tRETAINs RETINAs ...").  A card can have any number of
+   answers; a blank card of eight tiles often has over a hundred. */
+
+#ifndef CARD_H
+#define CARD_H
+
+#include "dawg.h"
+
+/* This program is designed with a maximum length of flashcard
+   in mind.  The size of the screen and letters determines this. */
+#define MAXWORDLENGTH       9
+
+/* There can't be more hooks on one side than letters */
+#define MAXNOHOOKS          26
+
+/* The bit of a letter in a set of hooks, and whether c is in hooks.
+   Either case of letter will do. */
+#define HOOKBIT(c)          (1UL << (((c) & 0x1F) - 1))
+#define HasHook(hooks, c)   (((hooks) & HOOKBIT(c)) != 0)
+#define HOOKALL             0x03FFFFFFUL
+
+/* First byte of a binary record.  A text record starts with a letter. */
+#define CARDMAGIC           0x01
+#define CARDVERSION         2
+
+
+/* cardHeaderType - The start of a binary record */
+typedef struct
+{
+  UInt8         magic;     /* CARDMAGIC */
+  UInt8         version;   /* CARDVERSION */
+  UInt16        count;     /* Number of answers */
+  UInt16        size;      /* Length of the record */
+  UInt16        question;  /* Offset of the question */
+} cardHeaderType;
+
+/* cardAnswerType - An answer of a binary record */
+typedef struct
+{
+  UInt16        word;      /* Offset of the answer */
+  UInt16        blank;     /* Letter the blank stands for ('A' to 'Z'), or 0 */
+  UInt32        front;     /* Front hooks */
+  UInt32        back;      /* Back hooks */
+} cardAnswerType;
+
+
+/* cardTextType - Somewhere to put a card parsed from a text record,
+   or made up rather than read */
+typedef struct
+{
+  Char          question[MAXWORDLENGTH + 1];
+  Char         *words;     /* The answers one after another, terminated */
+  UInt16        size;      /* Bytes words has room for */
+} cardTextType;
+
+/* cardType - A flashcard: the question, the answers and their hooks.
+   The strings point into the record for a binary card, and into text
+   for any other.  The arrays are the card's own, allocated to fit and
+   kept for the next card parsed into it - CardFree() lets them go.
+   words[count] is always an empty string. */
+typedef struct
+{
+  UInt16        count;     /* Number of answers to the flashcard */
+  const Char   *question;
+  const Char  **words;
+  UInt32       *front;
+  UInt32       *back;
+  Char         *blank;     /* Letter each answer's blank stands for, or 0 */
+  UInt16        room;      /* Answers the arrays have room for */
+  cardTextType  text;
+} cardType;
+
+/* A card with no answers, for when there is no card to show */
+extern const cardType cardNone;
+
+/* Shortest answer to a build-up card, and the most it has.  Every
+   array kept for each answer, here and in lf.c, has to fit in a chunk
+   of under 64K at this many - the biggest, the card's own, at 13 bytes
+   an answer. */
+#define BUILDUPMINLENGTH    3
+#define BUILDUPMAXWORDS     0x1000
+
+Boolean CardIsBinary(const void *rec, UInt32 size);
+Boolean CardParse(const void *rec, UInt32 size, cardType *card);
+void    CardFree(cardType *card);
+UInt16  CardHookString(UInt32 hooks, Char *s);
+
+UInt16  CardBuildUp(const dawgType *d, const Char *rack, UInt16 minlen, cardType *card);
+
+#endif
@@ -0,0 +1,591 @@
+/* -----------------------------------------------------------------------------
+   The lexicon's DAWG and GADDAG.
+
+   Patterns are matched by walking the graph with the set of places in
+   the pattern the letters so far could have got to - one bit a place -
+   rather than trying each way a '*' could go in turn.  A word is one
+   path through the DAWG, so it's found once however many ways it
+   matches.
+
+   In the GADDAG a pattern is started from the end of its longest run of
+   letters, walking back through the run and what comes before it, then
+   across the separator for what comes after.  A word can be reached
+   from each place in it the run fits, so it's only handed back from
+   the first of them.
+
+   The words a rack makes are found by walking the DAWG with the tiles
+   left, as counts and as a set of letters.  Only the edges of letters
+   in the set are followed, and once a node's edges are past the last
+   letter of the set there's nothing more in it - unless there's a
+   blank, a node is seldom looked at beyond a few of its edges.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "dawg.h"
+
+
+#define EdgeLetter(e)   ((UInt16) ((e) & 0x1F))
+#define EdgeEnd(e)      (((e) & 0x20) != 0)
+#define EdgeLast(e)     (((e) & 0x40) != 0)
+#define EdgeNode(e)     ((e) >> 7)
+
+#define Get32(p)        (((UInt32) (p)[0] << 24) | ((UInt32) (p)[1] << 16) \
+			 | ((UInt32) (p)[2] << 8) | (p)[3])
+
+/* Pattern codes beside the letters */
+#define PATONE          29  /* One letter or none */
+#define PATANY          30  /* '?' */
+#define PATRUN          31  /* '*' */
+
+/* Places a pattern can have - one bit each, with the end */
+#define PATMAX          31
+
+#define Bit(p)          (1UL << (p))
+
+/* matchType - A pattern being matched */
+typedef struct
+{
+  const dawgType *d;
+  const UInt8  *pat;
+  UInt16        n;
+  UInt16        minlen;    /* Shorter words aren't handed back */
+  UInt16        anchor;    /* Where the GADDAG starts in pat */
+  UInt8         left[PATMAX];  /* pat before anchor, backwards */
+  DawgWordFuncType fn;
+  void         *ctx;
+  Boolean       stopped;
+  Char          buf[2 * DAWGWORDMAX + 1];  /* Word found, anchor at DAWGWORDMAX */
+} matchType;
+
+/* rackWalkType - The words of a rack being found */
+typedef struct
+{
+  const dawgType *d;
+  UInt8         counts[27];  /* Tiles left of each letter, 1 for A */
+  UInt32        letters;     /* Letters with tiles left, A as bit 0 */
+  UInt16        blanks;      /* Blanks left */
+  UInt16        minlen;
+  DawgWordFuncType fn;
+  void         *ctx;
+  Boolean       stopped;
+  Char          buf[DAWGWORDMAX + 1];
+} rackWalkType;
+
+
+
+static UInt32 Edge(const dawgType *d, UInt32 i)
+{
+  const UInt8 *p = d->rec[i >> d->shift] + 4 * (i & (d->perrec - 1));
+
+  return Get32(p);
+}
+
+
+
+/* The edge for letter out of node, or 0 if there isn't one */
+static UInt32 Find(const dawgType *d, UInt32 node, UInt16 letter)
+{
+  UInt32 e;
+
+  if (node == 0)
+    return 0;
+
+  for (;; node++)
+    {
+      e = Edge(d, node);
+      if (EdgeLetter(e) == letter)
+	return e;
+      if (EdgeLetter(e) > letter || EdgeLast(e))
+	return 0;
+    }
+}
+
+
+
+/* 1 for A to 26 for Z, or 0 */
+static UInt16 Code(Char c)
+{
+  if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+    return c & 0x1F;
+
+  return 0;
+}
+
+
+
+/* Take the lexicon's header from record 0.  The caller then finds the
+   nrecs records of edges for rec. */
+Boolean DawgInit(dawgType *d, const UInt8 *header, UInt32 size)
+{
+  MemSet(d, sizeof(dawgType), 0);
+
+  if (size < DAWGHEADERSIZE || Get32(header) != DAWGMAGIC)
+    return false;
+
+  d->edges = Get32(header + 4);
+  d->dawg = Get32(header + 8);
+  d->gaddag = Get32(header + 12);
+  d->words = Get32(header + 16);
+  d->perrec = (header[20] << 8) | header[21];
+
+  for (d->shift = 0; d->shift < 16 && (1U << d->shift) != d->perrec; d->shift++)
+    ;
+  if (d->shift == 16 || d->edges == 0)
+    return false;
+
+  d->nrecs = (d->edges + d->perrec - 1) >> d->shift;
+  return true;
+}
+
+
+
+/* The edge the letters of word lead to from node, or 0 */
+static UInt32 Walk(const dawgType *d, UInt32 node, const Char *word, UInt16 len)
+{
+  UInt32 e = 0;
+  UInt16 i, c;
+
+  for (i = 0; i < len; i++)
+    {
+      if ((c = Code(word[i])) == 0 || (e = Find(d, node, c)) == 0)
+	return 0;
+      node = EdgeNode(e);
+    }
+
+  return e;
+}
+
+
+
+Boolean DawgHas(const dawgType *d, const Char *word, UInt16 len)
+{
+  UInt32 e;
+
+  if (len == 0)
+    return false;
+
+  e = Walk(d, d->dawg, word, len);
+  return e && EdgeEnd(e);
+}
+
+
+
+/* The letters of node's edges that end a word */
+static UInt32 Ends(const dawgType *d, UInt32 node)
+{
+  UInt32 hooks = 0, e;
+
+  if (node == 0)
+    return 0;
+
+  do
+    {
+      e = Edge(d, node++);
+      if (EdgeEnd(e) && EdgeLetter(e) <= 26)
+	hooks |= 1UL << (EdgeLetter(e) - 1);
+    }
+  while (!EdgeLast(e));
+
+  return hooks;
+}
+
+
+
+/* The letters that make a word put in front of or after word, one bit
+   a letter as card.h has them */
+void DawgHooks(const dawgType *d, const Char *word, UInt16 len, UInt32 *front, UInt32 *back)
+{
+  UInt32 e, node;
+  UInt16 i, c;
+
+  *front = *back = 0;
+  if (len == 0)
+    return;
+
+  if (d->gaddag)
+    {
+      /* The word backwards, then either a letter more backwards or the
+	 separator and a letter more forwards */
+      node = d->gaddag;
+      for (i = len; i > 0; i--)
+	{
+	  if ((c = Code(word[i - 1])) == 0 || (e = Find(d, node, c)) == 0)
+	    return;
+	  node = EdgeNode(e);
+	}
+
+      *front = Ends(d, node);
+      e = Find(d, node, DAWGSEPARATOR);
+      if (e)
+	*back = Ends(d, EdgeNode(e));
+      return;
+    }
+
+  e = Walk(d, d->dawg, word, len);
+  if (e)
+    *back = Ends(d, EdgeNode(e));
+
+  for (c = 1; c <= 26; c++)
+    {
+      e = Find(d, d->dawg, c);
+      if (e && (e = Walk(d, EdgeNode(e), word, len)) != 0 && EdgeEnd(e))
+	*front |= 1UL << (c - 1);
+    }
+}
+
+
+
+/* The places of pat that can be reached from set without a letter */
+static UInt32 Closure(const UInt8 *pat, UInt16 n, UInt32 set)
+{
+  UInt16 p;
+
+  for (p = 0; p < n; p++)
+    if ((set & Bit(p)) && (pat[p] == PATRUN || pat[p] == PATONE))
+      set |= Bit(p + 1);
+
+  return set;
+}
+
+
+
+/* The places of pat that letter c takes set to */
+static UInt32 Step(const UInt8 *pat, UInt16 n, UInt32 set, UInt16 c)
+{
+  UInt32 next = 0;
+  UInt16 p;
+
+  for (p = 0; p < n; p++)
+    if (set & Bit(p))
+      {
+	if (pat[p] == PATRUN)
+	  next |= Bit(p);
+	else if (pat[p] == c || pat[p] == PATANY || pat[p] == PATONE)
+	  next |= Bit(p + 1);
+      }
+
+  return next ? Closure(pat, n, next) : 0;
+}
+
+
+
+/* Does all of pat match the len letters of s? */
+static Boolean Glob(const UInt8 *pat, UInt16 n, const Char *s, UInt16 len)
+{
+  UInt32 set = Closure(pat, n, Bit(0));
+
+  while (len-- > 0 && set)
+    set = Step(pat, n, set, Code(*s++));
+
+  return (set & Bit(n)) != 0;
+}
+
+
+
+static void Emit(matchType *m, const Char *word, UInt16 len)
+{
+  if (len >= m->minlen && !m->fn(m->ctx, word, len))
+    m->stopped = true;
+}
+
+
+
+/* Forward through the DAWG from node, depth letters into the word */
+static void Forward(matchType *m, UInt32 node, UInt32 set, UInt16 depth)
+{
+  UInt32 e, next;
+
+  for (; node && !m->stopped; node++)
+    {
+      e = Edge(m->d, node);
+      next = Step(m->pat, m->n, set, EdgeLetter(e));
+      if (next)
+	{
+	  m->buf[depth] = 'A' + EdgeLetter(e) - 1;
+	  if (EdgeEnd(e) && (next & Bit(m->n)))
+	    Emit(m, m->buf, depth + 1);
+	  if (depth + 1 < DAWGWORDMAX)
+	    Forward(m, EdgeNode(e), next, depth + 1);
+	}
+
+      if (EdgeLast(e))
+	break;
+    }
+}
+
+
+
+/* Hand back the word found in the GADDAG with the anchor at i, unless
+   the pattern's anchor fits an earlier place in it too */
+static void EmitAnchored(matchType *m, UInt16 i, UInt16 len)
+{
+  const Char *word = m->buf + DAWGWORDMAX - i;
+  const UInt8 *after = m->pat + m->anchor + 1;
+  UInt16 q, n = m->n - m->anchor - 1;
+  Char c = 'A' + m->pat[m->anchor] - 1;
+
+  for (q = 0; q < i; q++)
+    if (word[q] == c && Glob(m->pat, m->anchor, word, q)
+	&& Glob(after, n, word + q + 1, len - q - 1))
+      return;
+
+  Emit(m, word, len);
+}
+
+
+
+/* After the separator, right letters past the anchor */
+static void Right(matchType *m, UInt32 node, UInt32 set, UInt16 left, UInt16 right)
+{
+  const UInt8 *after = m->pat + m->anchor + 1;
+  UInt16 n = m->n - m->anchor - 1;
+  UInt32 e, next;
+
+  for (; node && !m->stopped; node++)
+    {
+      e = Edge(m->d, node);
+      next = Step(after, n, set, EdgeLetter(e));
+      if (next)
+	{
+	  m->buf[DAWGWORDMAX + 1 + right] = 'A' + EdgeLetter(e) - 1;
+	  if (EdgeEnd(e) && (next & Bit(n)))
+	    EmitAnchored(m, left, left + right + 2);
+	  if (left + right + 2 < DAWGWORDMAX)
+	    Right(m, EdgeNode(e), next, left, right + 1);
+	}
+
+      if (EdgeLast(e))
+	break;
+    }
+}
+
+
+
+/* Back from the anchor through the GADDAG, left letters so far.  edge
+   is the one taken to node. */
+static void Left(matchType *m, UInt32 edge, UInt32 set, UInt16 left)
+{
+  const UInt8 *after = m->pat + m->anchor + 1;
+  UInt16 n = m->n - m->anchor - 1;
+  UInt32 node = EdgeNode(edge), e, next;
+
+  /* All the pattern before the anchor is used up - the word can start
+     here, and either end at the anchor or go on after it */
+  if (set & Bit(m->anchor))
+    {
+      if (EdgeEnd(edge) && (Closure(after, n, Bit(0)) & Bit(n)))
+	EmitAnchored(m, left, left + 1);
+
+      e = Find(m->d, node, DAWGSEPARATOR);
+      if (e && !m->stopped)
+	Right(m, EdgeNode(e), Closure(after, n, Bit(0)), left, 0);
+    }
+
+  for (; node && !m->stopped; node++)
+    {
+      e = Edge(m->d, node);
+      if (EdgeLetter(e) != DAWGSEPARATOR
+	  && (next = Step(m->left, m->anchor, set, EdgeLetter(e))) != 0
+	  && left + 1 < DAWGWORDMAX)
+	{
+	  m->buf[DAWGWORDMAX - 1 - left] = 'A' + EdgeLetter(e) - 1;
+	  Left(m, e, next, left + 1);
+	}
+
+      if (EdgeLast(e))
+	break;
+    }
+}
+
+
+
+/* Hand fn every word matching the n codes of pat, at least minlen long */
+static void Match(const dawgType *d, const UInt8 *pat, UInt16 n, UInt16 minlen,
+		  DawgWordFuncType fn, void *ctx)
+{
+  matchType m;
+  UInt16 p, run = 0, best = 0;
+  UInt32 e;
+
+  MemSet(&m, sizeof(m), 0);
+  m.d = d;
+  m.pat = pat;
+  m.n = n;
+  m.minlen = minlen;
+  m.fn = fn;
+  m.ctx = ctx;
+
+  /* The end of the longest run of letters */
+  for (p = 0; p < n; p++)
+    {
+      run = (pat[p] <= 26) ? run + 1 : 0;
+      if (run > best)
+	{
+	  best = run;
+	  m.anchor = p;
+	}
+    }
+
+  /* A pattern that starts with its longest run is as quick forwards */
+  if (!d->gaddag || best == 0 || best == m.anchor + 1)
+    {
+      Forward(&m, d->dawg, Closure(pat, n, Bit(0)), 0);
+      return;
+    }
+
+  for (p = 0; p < m.anchor; p++)
+    m.left[p] = pat[m.anchor - 1 - p];
+
+  e = Find(d, d->gaddag, pat[m.anchor]);
+  if (e)
+    {
+      m.buf[DAWGWORDMAX] = 'A' + pat[m.anchor] - 1;
+      Left(&m, e, Closure(m.left, m.anchor, Bit(0)), 0);
+    }
+}
+
+
+
+/* Hand fn each word that is word with up to before letters in front of
+   it and after behind it (but not word itself) */
+Boolean DawgExtend(const dawgType *d, const Char *word, UInt16 len, UInt16 before, UInt16 after,
+		   DawgWordFuncType fn, void *ctx)
+{
+  UInt8 pat[PATMAX];
+  UInt16 n = 0, i;
+
+  if (len == 0 || len + before + after > PATMAX)
+    return false;
+
+  for (i = 0; i < before; i++)
+    pat[n++] = PATONE;
+  for (i = 0; i < len; i++)
+    if ((pat[n++] = Code(word[i])) == 0)
+      return false;
+  for (i = 0; i < after; i++)
+    pat[n++] = PATONE;
+
+  Match(d, pat, n, len + 1, fn, ctx);
+  return true;
+}
+
+
+
+/* Hand fn each word matching pattern - letters, '?' for any one letter
+   and '*' for any run of them.  Returns false if it isn't a pattern. */
+Boolean DawgMatch(const dawgType *d, const Char *pattern, DawgWordFuncType fn, void *ctx)
+{
+  UInt8 pat[PATMAX];
+  UInt16 n = 0;
+
+  for (; *pattern; pattern++)
+    {
+      if (n == PATMAX)
+	return false;
+
+      if (*pattern == '?')
+	pat[n++] = PATANY;
+      else if (*pattern == '*')
+	{
+	  if (n == 0 || pat[n - 1] != PATRUN)
+	    pat[n++] = PATRUN;
+	}
+      else if ((pat[n++] = Code(*pattern)) == 0)
+	return false;
+    }
+
+  if (n == 0)
+    return false;
+
+  Match(d, pat, n, 1, fn, ctx);
+  return true;
+}
+
+
+
+static void RackWalk(rackWalkType *r, UInt32 node, UInt16 depth);
+
+/* Play the letter of edge e, now in buf at depth, and go on from it */
+static void RackPlay(rackWalkType *r, UInt32 e, UInt16 depth)
+{
+  if (EdgeEnd(e) && depth + 1 >= r->minlen && !r->fn(r->ctx, r->buf, depth + 1))
+    r->stopped = true;
+  else if (depth + 1 < DAWGWORDMAX && (r->letters || r->blanks))
+    RackWalk(r, EdgeNode(e), depth + 1);
+}
+
+
+
+/* Through the DAWG from node with the tiles left, depth letters into
+   the word.  A tile of the letter itself is used before a blank - the
+   other way round finds the same word again. */
+static void RackWalk(rackWalkType *r, UInt32 node, UInt16 depth)
+{
+  UInt32 e, bit;
+  UInt16 c;
+
+  for (; node && !r->stopped; node++)
+    {
+      e = Edge(r->d, node);
+      c = EdgeLetter(e);
+      if (c > 26)
+	break;
+      bit = Bit(c - 1);
+
+      if (r->letters & bit)
+	{
+	  r->buf[depth] = 'A' + c - 1;
+	  if (--r->counts[c] == 0)
+	    r->letters &= ~bit;
+	  RackPlay(r, e, depth);
+	  if (r->counts[c]++ == 0)
+	    r->letters |= bit;
+	}
+      else if (r->blanks)
+	{
+	  r->buf[depth] = 'a' + c - 1;
+	  r->blanks--;
+	  RackPlay(r, e, depth);
+	  r->blanks++;
+	}
+      else if ((r->letters >> c) == 0)
+	break;  /* No tiles for the letters after this one */
+
+      if (EdgeLast(e))
+	break;
+    }
+}
+
+
+
+/* Hand fn each word of minlen letters or more that the len tiles of
+   rack make, '?' being a blank.  The words come in alphabetical order,
+   with the letters blanks stand for in lowercase.  Returns false if
+   rack has anything else in it. */
+Boolean DawgAnagrams(const dawgType *d, const Char *rack, UInt16 len, UInt16 minlen,
+		     DawgWordFuncType fn, void *ctx)
+{
+  rackWalkType r;
+  UInt16 i, c;
+
+  MemSet(&r, sizeof(r), 0);
+  r.d = d;
+  r.minlen = minlen ? minlen : 1;
+  r.fn = fn;
+  r.ctx = ctx;
+
+  for (i = 0; i < len; i++)
+    if (rack[i] == '?')
+      r.blanks++;
+    else if ((c = Code(rack[i])) == 0)
+      return false;
+    else if (r.counts[c] < 0xFF)
+      {
+	r.counts[c]++;
+	r.letters |= Bit(c - 1);
+      }
+
+  if (r.letters || r.blanks)
+    RackWalk(&r, d->dawg, 0);
+  return true;
+}
@@ -0,0 +1,77 @@
+/* The lexicon: a word list as a minimal DAWG, with an optional GADDAG.
+
+   The lexicon DB (type 'Dawg', made by tools/mkdawg) is an array of
+   edges cut into records of perrec edges each, after record 0, the
+   header:
+
+       UInt8    magic[4]   "LFDW"
+       UInt8    edges[4]   edges in all, including the unused edge 0
+       UInt8    dawg[4]    first edge of the DAWG's root
+       UInt8    gaddag[4]  ... and of the GADDAG's, or 0 for none
+       UInt8    words[4]
+       UInt8    perrec[2]  a power of two, so an edge is found with a shift
+
+   An edge is four bytes, big-endian:
+
+       bits 0-4   letter, 1 for A to 26 for Z (DAWGSEPARATOR in the GADDAG)
+       bit  5     a word ends here
+       bit  6     the last edge of its node
+       bits 7-31  first edge of the node it leads to, or 0 for none
+
+   A node is its edges, next to each other in letter order.  Nodes with
+   the same edges are one node, so the DAWG takes little more room than
+   the suffixes the words don't share.
+
+   The GADDAG holds every word once for each of its letters: the
+   letters up to that one backwards, then DAWGSEPARATOR and the rest
+   (left off when there is no rest).  Any run of letters is a path from
+   its root - backwards - after which the ways the word can go on are
+   to the left, or past the separator to the right.  That makes front
+   hooks and words with a given middle as quick as back hooks and words
+   with a given start.  It's a good deal bigger than the DAWG.
+
+   Words are passed in and handed back in either case; handed back
+   they're uppercase, but for letters a blank stands for.  Nothing here touches the Data Manager - the
+   records are found for it - so the tools can use it too. */
+
+#ifndef DAWG_H
+#define DAWG_H
+
+#define DAWGMAGIC          0x4C464457UL  /* 'LFDW' */
+#define DAWGHEADERSIZE     22
+
+#define DAWGSEPARATOR      27
+
+/* Longest word the lexicon holds */
+#define DAWGWORDMAX        15
+
+/* Edges to a record, as mkdawg writes them */
+#define DAWGRECEDGES       8192
+
+/* dawgType - A lexicon, its records where they are */
+typedef struct
+{
+  const UInt8 **rec;       /* rec[i] holds edges i * perrec on */
+  UInt16        nrecs;
+  UInt16        perrec;
+  UInt16        shift;     /* perrec is 1 << shift */
+  UInt32        edges;
+  UInt32        dawg;      /* Roots */
+  UInt32        gaddag;
+  UInt32        words;
+} dawgType;
+
+/* Called for each word found, len letters in word.  Return false to
+   stop looking. */
+typedef Boolean (*DawgWordFuncType)(void *ctx, const Char *word, UInt16 len);
+
+Boolean DawgInit(dawgType *d, const UInt8 *header, UInt32 size);
+Boolean DawgHas(const dawgType *d, const Char *word, UInt16 len);
+void    DawgHooks(const dawgType *d, const Char *word, UInt16 len, UInt32 *front, UInt32 *back);
+Boolean DawgExtend(const dawgType *d, const Char *word, UInt16 len, UInt16 before, UInt16 after,
+		   DawgWordFuncType fn, void *ctx);
+Boolean DawgMatch(const dawgType *d, const Char *pattern, DawgWordFuncType fn, void *ctx);
+Boolean DawgAnagrams(const dawgType *d, const Char *rack, UInt16 len, UInt16 minlen,
+		     DawgWordFuncType fn, void *ctx);
+
+#endif
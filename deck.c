@@ -0,0 +1,238 @@
+/* -----------------------------------------------------------------------------
+   Open flashcard deck and parsed-card cache for LAMPFlash.
+
+   The cache is a handful of entries searched in turn, each stamped with
+   the time it was last used.  With so few entries a linear search is
+   quicker than keeping a list in order, and the entry with the oldest
+   stamp is the one replaced.
+
+   Cards read ahead are stamped as if just used and flagged until they
+   are asked for, which is how the read ahead hit rate is counted.
+
+   A binary card points into its record, so the record is kept locked
+   for as long as the card is in the cache.  Each entry's card keeps the
+   arrays it was last parsed into, so they're only allocated afresh for
+   a card with more answers than that.  The card last handed out by
+   DeckCard() is never the one replaced by a read ahead, so the caller
+   can hold on to it until it asks for another.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "deck.h"
+
+
+/* Open the named flashcard DB read-only and set up the cache.  Any deck
+   already open is closed first. */
+Err DeckOpen(deckType *d, const Char *name)
+{
+  LocalID dbID;
+  UInt16 i;
+
+  DeckClose(d);
+
+  dbID = DmFindDatabase(0, name);
+  if (!dbID)
+    return dmErrCantFind;
+
+  d->ref = DmOpenDatabase(0, dbID, dmModeReadOnly);
+  if (!d->ref)
+    return DmGetLastErr();
+
+  d->numrec = DmNumRecords(d->ref);
+  d->lookups = d->hits = 0;
+  d->fetched = d->used = d->wasted = 0;
+
+  /* A smaller cache will do if memory is short but we need at least
+     one entry to parse cards into */
+  for (d->size = DECKCACHESIZE; d->size > 0; d->size >>= 1)
+    {
+      d->cache = MemPtrNew(d->size * sizeof(deckEntryType));
+      if (d->cache)
+	break;
+    }
+
+  if (!d->cache)
+    {
+      DeckClose(d);
+      return memErrNotEnoughSpace;
+    }
+
+  for (i = 0; i < d->size; i++)
+    {
+      d->cache[i].rec = DECKNOREC;
+      d->cache[i].used = 0;
+      d->cache[i].ahead = false;
+      d->cache[i].locked = NULL;
+      MemSet(&d->cache[i].card, sizeof(cardType), 0);
+    }
+
+  d->current = NULL;
+
+  d->depth = (d->size / 2 < DECKPREFETCH) ? d->size / 2 : DECKPREFETCH;
+
+  return errNone;
+}
+
+
+
+/* Close the deck and free the cache.  Safe to call when nothing is open. */
+void DeckClose(deckType *d)
+{
+  UInt16 i;
+
+  for (i = 0; i < d->size; i++)
+    {
+      if (d->cache[i].locked)
+	MemHandleUnlock(d->cache[i].locked);
+      CardFree(&d->cache[i].card);
+    }
+
+  if (d->ref)
+    DmCloseDatabase(d->ref);
+
+  if (d->cache)
+    MemPtrFree(d->cache);
+
+  d->ref = NULL;
+  d->cache = NULL;
+  d->current = NULL;
+  d->numrec = 0;
+  d->size = 0;
+  d->depth = 0;
+  d->clock = 0;
+}
+
+
+
+/* Find record rec in the cache.  If it isn't there then *slot is set
+   to the least recently used entry, which is where it should go. */
+static deckEntryType *DeckFind(deckType *d, UInt32 rec, deckEntryType **slot)
+{
+  deckEntryType *e, *oldest = d->cache;
+  UInt16 i;
+
+  for (i = 0, e = d->cache; i < d->size; i++, e++)
+    {
+      if (e->rec == rec)
+	return e;
+
+      /* Unused entries have never been used so go first.  The card
+	 the caller has is kept unless it's all we have room for. */
+      if (e != d->current && (e->used < oldest->used || oldest == d->current))
+	oldest = e;
+    }
+
+  *slot = oldest;
+  return NULL;
+}
+
+
+
+/* Parse record rec into cache entry e */
+static Boolean DeckLoad(deckType *d, UInt32 rec, deckEntryType *e)
+{
+  MemHandle h;
+  MemPtr p;
+  UInt32 size;
+
+  h = DmQueryRecord(d->ref, (UInt16) rec);
+  if (!h)
+    return false;
+
+  /* A card read ahead is being thrown away unseen */
+  if (e->ahead)
+    d->wasted++;
+
+  if (e->locked)
+    MemHandleUnlock(e->locked);
+  e->locked = NULL;
+  e->rec = DECKNOREC;
+  e->ahead = false;
+
+  p = MemHandleLock(h);
+  size = MemHandleSize(h);
+
+  if (!CardParse(p, size, &e->card))
+    {
+      /* Damaged record */
+      MemHandleUnlock(h);
+      return false;
+    }
+
+  /* Only a binary card needs its record to stay put */
+  if (CardIsBinary(p, size))
+    e->locked = h;
+  else
+    MemHandleUnlock(h);
+
+  e->rec = rec;
+  e->used = d->clock;
+  e->ahead = false;
+
+  return true;
+}
+
+
+
+/* The parsed card of record rec, from the cache if we have it.  Returns
+   NULL if the record can't be read.  The card is good until the next
+   call - even one that fails, as the last card may be parsed over. */
+const cardType *DeckCard(deckType *d, UInt32 rec)
+{
+  deckEntryType *e, *slot;
+
+  if (!d->ref || rec >= d->numrec)
+    return NULL;
+
+  d->clock++;
+  d->lookups++;
+
+  e = DeckFind(d, rec, &slot);
+  if (e)
+    {
+      d->hits++;
+      if (e->ahead)
+	{
+	  d->used++;
+	  e->ahead = false;
+	}
+      e->used = d->clock;
+      d->current = e;
+      return &e->card;
+    }
+
+  /* Not cached - parse it into the least recently used entry */
+  if (!DeckLoad(d, rec, slot))
+    {
+      if (slot == d->current)
+	d->current = NULL;
+      return NULL;
+    }
+
+  d->current = slot;
+  return &slot->card;
+}
+
+
+
+/* Read record rec into the cache ahead of it being asked for.  This is
+   called from the event loop when there is nothing else to do, one card
+   at a time so that the user never waits on it. */
+void DeckPrefetch(deckType *d, UInt32 rec)
+{
+  deckEntryType *slot;
+
+  if (!d->ref || rec >= d->numrec)
+    return;
+
+  if (DeckFind(d, rec, &slot))
+    return;
+
+  d->clock++;
+  if (DeckLoad(d, rec, slot))
+    {
+      slot->ahead = true;
+      d->fetched++;
+    }
+}
@@ -0,0 +1,62 @@
+/* The open flashcard deck.
+
+   The flashcard DB used to be found, opened, queried and closed again
+   for every card shown.  It is now opened once when the main form opens
+   and held until the quiz stops, and the last few cards parsed are kept
+   in a small cache so that going back and forth between cards, or
+   showing one again, doesn't touch the Data Manager at all.
+
+   While the user is thinking the next few cards of the quiz order are
+   read ahead into the cache too (see DeckPrefetch()), so moving on to
+   the next card is normally just a copy out of memory. */
+
+#ifndef DECK_H
+#define DECK_H
+
+#include "card.h"
+
+/* Number of parsed cards kept */
+#define DECKCACHESIZE       8
+
+/* Number of cards read ahead of the current one.  No more than half
+   the cache is used so that the cards just seen are kept too. */
+#define DECKPREFETCH        4
+
+/* Marks an unused cache entry */
+#define DECKNOREC           0xFFFFFFFFUL
+
+/* deckEntryType - A parsed card in the cache */
+typedef struct
+{
+  UInt32        rec;      /* Record the card was parsed from, or DECKNOREC */
+  UInt32        used;     /* Time of last use - the lowest is evicted */
+  Boolean       ahead;    /* Read ahead and not yet asked for */
+  MemHandle     locked;   /* Record held locked for a binary card */
+  cardType      card;
+} deckEntryType;
+
+/* deckType - The open deck */
+typedef struct
+{
+  DmOpenRef      ref;      /* NULL when no deck is open */
+  UInt32         numrec;   /* Number of records (cards) in the deck */
+  UInt32         clock;    /* Counts cache lookups for the LRU */
+  UInt16         size;     /* Entries in the cache */
+  UInt16         depth;    /* Cards to read ahead */
+  deckEntryType *cache;
+  deckEntryType *current;  /* Card last handed out by DeckCard() */
+
+  /* Counters for the cache statistics */
+  UInt32         lookups;  /* Cards asked for */
+  UInt32         hits;     /* ... and found in the cache */
+  UInt32         fetched;  /* Cards read ahead */
+  UInt32         used;     /* ... and then asked for */
+  UInt32         wasted;   /* ... and evicted before being asked for */
+} deckType;
+
+Err             DeckOpen(deckType *d, const Char *name);
+void            DeckClose(deckType *d);
+const cardType *DeckCard(deckType *d, UInt32 rec);
+void            DeckPrefetch(deckType *d, UInt32 rec);
+
+#endif
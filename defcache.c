@@ -0,0 +1,126 @@
+/* -----------------------------------------------------------------------------
+   Cache of recent dictionary lookups for LAMPFlash.
+
+   Each entry is one chunk so that adding and dropping one is a single
+   allocation.  If there isn't the memory for a new entry the lookup
+   just isn't kept.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "dict.h"
+#include "defcache.h"
+
+
+
+/* Free an entry */
+static void DefCacheDrop(defCacheType *c, defCacheEntryType *e)
+{
+  if (!e->h)
+    return;
+
+  c->bytes -= MemHandleSize(e->h);
+  MemHandleUnlock(e->h);
+  MemHandleFree(e->h);
+  e->h = NULL;
+}
+
+
+
+/* An unused entry if there is one, otherwise the least recently used -
+   or if used is true the least recently used, or NULL if none is */
+static defCacheEntryType *DefCacheOldest(defCacheType *c, Boolean used)
+{
+  defCacheEntryType *lru = NULL;
+  UInt16 i;
+
+  for (i = 0; i < DEFCACHESIZE; i++)
+    {
+      if (!c->e[i].h)
+	{
+	  if (!used)
+	    return &c->e[i];
+	}
+      else if (!lru || c->e[i].used < lru->used)
+	lru = &c->e[i];
+    }
+
+  return lru;
+}
+
+
+
+/* The lookup of key, or NULL if it isn't kept */
+const defCacheEntryType *DefCacheFind(defCacheType *c, const Char *key)
+{
+  UInt16 i;
+
+  c->lookups++;
+
+  for (i = 0; i < DEFCACHESIZE; i++)
+    if (c->e[i].h && StrCompare(c->e[i].key, key) == 0)
+      {
+	c->hits++;
+	c->e[i].used = ++c->clock;
+	return &c->e[i];
+      }
+
+  return NULL;
+}
+
+
+
+/* Keep the lookup of key - word and def found at pos - making room for
+   it by dropping the least recently used */
+void DefCacheAdd(defCacheType *c, const Char *key, const dictPosType *pos,
+		 const Char *word, const Char *def)
+{
+  defCacheEntryType *e;
+  UInt16 keylen = StrLen(key) + 1, wordlen = StrLen(word) + 1;
+  UInt32 size = (UInt32) keylen + wordlen + StrLen(def) + 1;
+  Char *p;
+  UInt16 i;
+
+  if (size > DEFCACHEBYTES)
+    return;
+
+  /* A lookup already kept is replaced */
+  for (i = 0; i < DEFCACHESIZE; i++)
+    if (c->e[i].h && StrCompare(c->e[i].key, key) == 0)
+      DefCacheDrop(c, &c->e[i]);
+
+  while (c->bytes + size > DEFCACHEBYTES && (e = DefCacheOldest(c, true)) != NULL)
+    DefCacheDrop(c, e);
+
+  e = DefCacheOldest(c, false);
+  DefCacheDrop(c, e);
+
+  e->h = MemHandleNew(size);
+  if (!e->h)
+    return;
+
+  p = MemHandleLock(e->h);
+  StrCopy(p, key);
+  StrCopy(p + keylen, word);
+  StrCopy(p + keylen + wordlen, def);
+
+  e->key = p;
+  e->word = p + keylen;
+  e->def = p + keylen + wordlen;
+  e->pos = *pos;
+  e->used = ++c->clock;
+  c->bytes += size;
+}
+
+
+
+/* Free every entry */
+void DefCacheFree(defCacheType *c)
+{
+  UInt16 i;
+
+  for (i = 0; i < DEFCACHESIZE; i++)
+    DefCacheDrop(c, &c->e[i]);
+
+  c->bytes = 0;
+}
@@ -0,0 +1,56 @@
+/* Definitions looked up recently.
+
+   The same few hundred answers get looked up again and again in a
+   session - from the answer list, then the Dict form, then the list
+   again.  Each lookup is kept, ready to show, against the word that was
+   asked for: the word found (the one after it if it isn't in the
+   dictionary), where it is, and its definition as it's displayed.  A
+   word looked up again is shown straight from here without going near
+   the dictionary.
+
+   Entries are found and replaced the way the deck cache does it (see
+   deck.h) - a linear search, and the least recently used goes first.
+   Besides the number of entries the bytes held are capped, as
+   definitions vary so much in length. */
+
+#ifndef DEFCACHE_H
+#define DEFCACHE_H
+
+#include "dict.h"
+
+/* Most entries kept, and most bytes of words and definitions */
+#define DEFCACHESIZE        32
+#define DEFCACHEBYTES     8192
+
+/* defCacheEntryType - A lookup.  The handle holds the word asked for,
+   the word found and the definition, each ended by a NULL, and is
+   locked while in the cache. */
+typedef struct
+{
+  MemHandle     h;         /* NULL if the entry is unused */
+  UInt32        used;      /* Time of last use - the lowest is replaced */
+  dictPosType   pos;
+  const Char   *key;       /* ... locked */
+  const Char   *word;
+  const Char   *def;
+} defCacheEntryType;
+
+/* defCacheType - The cache */
+typedef struct
+{
+  UInt32            clock;
+  UInt32            bytes;     /* Held by all the entries */
+  defCacheEntryType e[DEFCACHESIZE];
+
+  /* Counters for the cache statistics */
+  UInt32            lookups;
+  UInt32            hits;
+} defCacheType;
+
+const defCacheEntryType *DefCacheFind(defCacheType *c, const Char *key);
+void                     DefCacheAdd(defCacheType *c, const Char *key,
+				     const dictPosType *pos, const Char *word,
+				     const Char *def);
+void                     DefCacheFree(defCacheType *c);
+
+#endif
@@ -0,0 +1,1064 @@
+/* -----------------------------------------------------------------------------
+   Dictionary access for LAMPFlash.
+
+   The first-word index is one chunk - a dictIndexType, the offsets and
+   the keys - so that saving it to the sidecar and reading it back is a
+   single copy.  Offsets are 16 bits, so a dictionary whose first words
+   come to more than 64K between them goes without an index and the
+   search reads the records as it always did.
+
+   The records themselves, plain or packed, are read by dictrec.c.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "dictrec.h"
+#include "dict.h"
+
+
+#define DictIndexSize(nrecs, keysize) \
+  (sizeof(dictIndexType) + (UInt32) (nrecs) * sizeof(UInt16) + (keysize))
+
+
+
+/* Copy the first word of record rec to word.  Returns its length, or 0
+   if the record can't be read. */
+static UInt16 DictReadFirstWord(DmOpenRef ref, UInt16 rec, Char *word)
+{
+  MemHandle h;
+  UInt16 n = 0;
+
+  h = DmQueryRecord(ref, rec);
+  if (h)
+    {
+      n = DictRecFirstWord(MemHandleLock(h), MemHandleSize(h), word, MAXDBTITLE);
+      MemHandleUnlock(h);
+    }
+  else
+    word[0] = '\0';
+
+  return n;
+}
+
+
+
+/* Point the dictType at the parts of its index */
+static void DictLockIndex(dictType *d)
+{
+  d->index = MemHandleLock(d->indexh);
+  d->offsets = (UInt16 *) (d->index + 1);
+  d->keys = (Char *) (d->offsets + d->nrecs);
+}
+
+
+
+/* Read the first word of every record into a new index */
+static Boolean DictBuildIndex(dictType *d, const Char *name, UInt32 modified)
+{
+  Char word[MAXDBTITLE + 1];
+  UInt32 keysize = 0;
+  UInt16 i, n;
+
+  /* Add up the space needed first */
+  for (i = 0; i < d->nrecs; i++)
+    keysize += DictReadFirstWord(d->ref, i, word) + 1;
+
+  if (keysize > 0xFFFF)
+    return false;
+
+  d->indexh = MemHandleNew(DictIndexSize(d->nrecs, keysize));
+  if (!d->indexh)
+    return false;
+
+  DictLockIndex(d);
+  StrNCopy(d->index->title, name, MAXDBTITLE - 1);
+  d->index->title[MAXDBTITLE - 1] = '\0';
+  d->index->magic = DICTINDEXMAGIC;
+  d->index->modified = modified;
+  d->index->nrecs = d->nrecs;
+  d->index->keysize = keysize;
+
+  for (i = 0, n = 0; i < d->nrecs; i++)
+    {
+      d->offsets[i] = n;
+      n += DictReadFirstWord(d->ref, i, d->keys + n) + 1;
+    }
+
+  return true;
+}
+
+
+
+/* Take a copy of the index p, of size bytes, if it is whole and is for
+   a dictionary of as many records as this one */
+static Boolean DictCopyIndex(dictType *d, const dictIndexType *p, UInt32 size)
+{
+  const UInt16 *offsets = (const UInt16 *) (p + 1);
+  const Char *keys = (const Char *) (offsets + p->nrecs);
+  UInt16 i;
+
+  if (size < sizeof(dictIndexType) || p->magic != DICTINDEXMAGIC
+      || p->nrecs != d->nrecs || p->keysize == 0
+      || size < DictIndexSize(p->nrecs, p->keysize)
+      || keys[p->keysize - 1] != '\0')
+    return false;
+
+  for (i = 0; i < p->nrecs; i++)
+    if (offsets[i] >= p->keysize)
+      return false;
+
+  size = DictIndexSize(p->nrecs, p->keysize);
+  d->indexh = MemHandleNew(size);
+  if (!d->indexh)
+    return false;
+
+  DictLockIndex(d);
+  MemMove(d->index, p, size);
+
+  return true;
+}
+
+
+
+/* Take the index from the dictionary's app info block, where mkdict
+   puts it */
+static Boolean DictLoadAppInfo(dictType *d, LocalID appInfo)
+{
+  dictIndexType *p;
+
+  if (!appInfo)
+    return false;
+
+  p = MemLocalIDToLockedPtr(appInfo, 0);
+  if (!p)
+    return false;
+
+  DictCopyIndex(d, p, MemPtrSize(p));
+  MemPtrUnlock(p);
+
+  return (d->indexh != NULL);
+}
+
+
+
+/* Look for a saved index of the dictionary that is still good */
+static Boolean DictLoadIndex(dictType *d, const Char *name, UInt32 modified,
+			     const Char *sidecar)
+{
+  LocalID dbID;
+  DmOpenRef ref;
+  MemHandle h;
+  dictIndexType *p;
+  UInt16 i, records;
+  UInt32 size;
+
+  dbID = DmFindDatabase(0, sidecar);
+  if (!dbID)
+    return false;
+
+  ref = DmOpenDatabase(0, dbID, dmModeReadOnly);
+  if (!ref)
+    return false;
+
+  records = DmNumRecords(ref);
+  for (i = 0; i < records && !d->indexh; i++)
+    {
+      h = DmQueryRecord(ref, i);
+      if (h == NULL || (size = MemHandleSize(h)) < sizeof(dictIndexType))
+	continue;
+
+      p = MemHandleLock(h);
+      if (p->magic == DICTINDEXMAGIC && StrCompare(p->title, name) == 0
+	  && p->modified == modified)
+	DictCopyIndex(d, p, size);
+      MemHandleUnlock(h);
+    }
+
+  DmCloseDatabase(ref);
+
+  return (d->indexh != NULL);
+}
+
+
+
+/* Save the index to the sidecar, replacing any older one */
+static void DictSaveIndex(dictType *d, const Char *sidecar)
+{
+  LocalID dbID;
+  DmOpenRef ref;
+  MemHandle h;
+  dictIndexType *p;
+  UInt16 i = 0, index;
+  UInt32 size = DictIndexSize(d->nrecs, d->index->keysize);
+  Boolean match;
+
+  dbID = DmFindDatabase(0, sidecar);
+  if (!dbID)
+    return;
+
+  ref = DmOpenDatabase(0, dbID, dmModeReadWrite);
+  if (!ref)
+    return;
+
+  /* Removing a record shuffles the rest down so don't advance */
+  while (i < DmNumRecords(ref))
+    {
+      match = false;
+      h = DmQueryRecord(ref, i);
+      if (h && MemHandleSize(h) >= sizeof(dictIndexType))
+	{
+	  p = MemHandleLock(h);
+	  match = (p->magic == DICTINDEXMAGIC && StrCompare(p->title, d->index->title) == 0);
+	  MemHandleUnlock(h);
+	}
+
+      if (match)
+	DmRemoveRecord(ref, i);
+      else
+	i++;
+    }
+
+  /* Not being able to save it only costs time next run */
+  index = dmMaxRecordIndex;
+  h = DmNewRecord(ref, &index, size);
+  if (h)
+    {
+      DmWrite(MemHandleLock(h), 0, d->index, size);
+      MemHandleUnlock(h);
+      DmReleaseRecord(ref, index, true);
+    }
+
+  DmCloseDatabase(ref);
+}
+
+
+
+/* Free the buffer for unpacked definitions */
+static void DictFreeUnpack(dictType *d)
+{
+  if (d->unpackh)
+    {
+      MemHandleUnlock(d->unpackh);
+      MemHandleFree(d->unpackh);
+    }
+
+  d->unpackh = NULL;
+  d->unpacksize = 0;
+}
+
+
+
+/* Make sure the buffer for unpacked definitions holds at least size
+   bytes, growing it if not.  Returns false if there isn't the memory. */
+static Boolean DictUnpackBuffer(dictType *d, UInt32 size)
+{
+  if (size <= d->unpacksize && d->unpackh)
+    return true;
+
+  DictFreeUnpack(d);
+
+  d->unpackh = MemHandleNew(size ? size : 1);
+  if (!d->unpackh)
+    return false;
+  d->unpack = MemHandleLock(d->unpackh);
+  d->unpacksize = size;
+
+  return true;
+}
+
+
+
+/* Let go of a record's table and the record */
+static void DictDropTable(dictTableType *t)
+{
+  if (t->keysh)
+    {
+      MemHandleUnlock(t->keysh);
+      MemHandleFree(t->keysh);
+    }
+
+  if (t->rech)
+    MemHandleUnlock(t->rech);
+
+  t->rech = NULL;
+  t->keysh = NULL;
+  t->count = 0;
+}
+
+
+
+/* The table of record rec, making it if it isn't kept.  Returns NULL if
+   the record can't be read or there isn't the memory. */
+static dictTableType *DictTable(dictType *d, UInt16 rec)
+{
+  dictTableType *t, *lru;
+  UInt32 size, keysize;
+  UInt16 i, wordsize;
+
+  lru = &d->tables[0];
+  for (i = 0; i < DICTTABLES; i++)
+    {
+      t = &d->tables[i];
+      if (t->rech && t->rec == rec)
+	{
+	  t->used = ++d->clock;
+	  return t;
+	}
+
+      if (!t->rech || (lru->rech && t->used < lru->used))
+	lru = t;
+    }
+
+  if (rec >= d->nrecs)
+    return NULL;
+
+  t = lru;
+  DictDropTable(t);
+
+  t->rech = DmQueryRecord(d->ref, rec);
+  if (!t->rech)
+    return NULL;
+
+  size = MemHandleSize(t->rech);
+  t->text = MemHandleLock(t->rech);
+  t->count = DictRecScan(t->text, size, NULL, NULL, &wordsize);
+
+  /* Room for one key at least so that an empty record still has a table */
+  keysize = (t->count ? t->count : 1) * sizeof(dictKeyType);
+  t->keysh = MemHandleNew(keysize + wordsize);
+  if (!t->keysh)
+    {
+      DictDropTable(t);
+      return NULL;
+    }
+
+  t->keys = MemHandleLock(t->keysh);
+  t->packed = DictRecIsPacked(t->text, size);
+  t->words = wordsize ? (Char *) t->keys + keysize : t->text;
+  DictRecScan(t->text, size, t->keys, (Char *) t->words, NULL);
+
+  t->rec = rec;
+  t->used = ++d->clock;
+
+  return t;
+}
+
+
+
+/* The name of one of the dictionary's companion DBs - the dictionary's
+   name with suffix ("-sigs" or "-xref") on the end */
+static void DictCompanionName(dictType *d, const Char *suffix, Char *dbname)
+{
+  StrNCopy(dbname, d->name, MAXDBTITLE - 1 - StrLen(suffix));
+  dbname[MAXDBTITLE - 1 - StrLen(suffix)] = '\0';
+  StrCat(dbname, suffix);
+}
+
+
+
+/* Write the signatures of every word to a new signature DB, left open
+   as d->sigref.  Returns false (with nothing left behind) if a record
+   can't be read or there isn't the room. */
+static Boolean DictBuildSigs(dictType *d, const Char *signame)
+{
+  dictSigHeaderType header;
+  dictTableType *t;
+  const dictKeyType *k;
+  LocalID dbID;
+  MemHandle h, sigsh;
+  UInt32 *sigs, magic = DICTSIGMAGIC;
+  UInt16 rec, i, index;
+  Boolean ok = true;
+
+  if (DmCreateDatabase(0, signame, CREATORID, DICTSIGTYPE, false) != errNone)
+    return false;
+
+  dbID = DmFindDatabase(0, signame);
+  d->sigref = dbID ? DmOpenDatabase(0, dbID, dmModeReadWrite) : NULL;
+  if (!d->sigref)
+    {
+      if (dbID)
+	DmDeleteDatabase(0, dbID);
+      return false;
+    }
+
+  header.magic = 0;
+  header.modified = d->modified;
+  header.nrecs = d->nrecs;
+
+  index = 0;
+  h = DmNewRecord(d->sigref, &index, sizeof(header));
+  if (h)
+    {
+      DmWrite(MemHandleLock(h), 0, &header, sizeof(header));
+      MemHandleUnlock(h);
+      DmReleaseRecord(d->sigref, index, true);
+    }
+  ok = (h != NULL);
+
+  /* An empty record still gets one signature - it has no length to match */
+  for (rec = 0; rec < d->nrecs && ok; rec++)
+    {
+      t = DictTable(d, rec);
+      sigsh = t ? MemHandleNew((t->count ? t->count : 1) * sizeof(UInt32)) : NULL;
+      if (!sigsh)
+	{
+	  ok = false;
+	  break;
+	}
+
+      sigs = MemHandleLock(sigsh);
+      sigs[0] = 0xFFFFFFFFUL;
+      for (i = 0; i < t->count; i++)
+	{
+	  k = &t->keys[i];
+	  sigs[i] = SearchSignature(t->words + k->word, k->wordlen);
+	}
+
+      index = rec + 1;
+      h = DmNewRecord(d->sigref, &index, MemHandleSize(sigsh));
+      if (h)
+	{
+	  DmWrite(MemHandleLock(h), 0, sigs, MemHandleSize(sigsh));
+	  MemHandleUnlock(h);
+	  DmReleaseRecord(d->sigref, index, true);
+	}
+      else
+	ok = false;
+
+      MemHandleUnlock(sigsh);
+      MemHandleFree(sigsh);
+    }
+
+  if (ok && (h = DmGetRecord(d->sigref, 0)) != NULL)
+    {
+      DmWrite(MemHandleLock(h), OffsetOf(dictSigHeaderType, magic), &magic, sizeof(magic));
+      MemHandleUnlock(h);
+      DmReleaseRecord(d->sigref, 0, true);
+    }
+  else
+    ok = false;
+
+  if (!ok)
+    {
+      DmCloseDatabase(d->sigref);
+      DmDeleteDatabase(0, dbID);
+      d->sigref = NULL;
+    }
+
+  return ok;
+}
+
+
+
+/* Open the signature DB, making it if there isn't a good one.  Returns
+   false if we have to do without. */
+static Boolean DictOpenSigs(dictType *d)
+{
+  Char signame[MAXDBTITLE];
+  dictSigHeaderType *header;
+  LocalID dbID;
+  MemHandle h;
+  Boolean good = false;
+
+  if (d->sigref)
+    return true;
+  if (d->nosigs)
+    return false;
+
+  DictCompanionName(d, "-sigs", signame);
+  dbID = DmFindDatabase(0, signame);
+  if (dbID)
+    {
+      d->sigref = DmOpenDatabase(0, dbID, dmModeReadOnly);
+      if (d->sigref && DmNumRecords(d->sigref) == d->nrecs + 1
+	  && (h = DmQueryRecord(d->sigref, 0)) != NULL
+	  && MemHandleSize(h) >= sizeof(dictSigHeaderType))
+	{
+	  header = MemHandleLock(h);
+	  good = (header->magic == DICTSIGMAGIC && header->modified == d->modified
+		  && header->nrecs == d->nrecs);
+	  MemHandleUnlock(h);
+	}
+
+      if (good)
+	return true;
+
+      /* Out of date, or a build that didn't finish */
+      if (d->sigref)
+	DmCloseDatabase(d->sigref);
+      d->sigref = NULL;
+      DmDeleteDatabase(0, dbID);
+    }
+
+  if (!DictBuildSigs(d, signame))
+    d->nosigs = true;
+
+  return !d->nosigs;
+}
+
+
+
+/* Open the cross-reference DB if there's one that goes with the
+   dictionary.  Returns false if there isn't. */
+static Boolean DictOpenXref(dictType *d)
+{
+  Char xrefname[MAXDBTITLE];
+  dictXrefHeaderType *header;
+  LocalID dbID;
+  MemHandle h;
+  Boolean good = false;
+
+  if (d->xrefref)
+    return true;
+  if (d->noxref)
+    return false;
+
+  DictCompanionName(d, "-xref", xrefname);
+  dbID = DmFindDatabase(0, xrefname);
+  d->xrefref = dbID ? DmOpenDatabase(0, dbID, dmModeReadOnly) : NULL;
+  if (d->xrefref && DmNumRecords(d->xrefref) == d->nrecs + 1
+      && (h = DmQueryRecord(d->xrefref, 0)) != NULL
+      && MemHandleSize(h) >= sizeof(dictXrefHeaderType))
+    {
+      header = MemHandleLock(h);
+      good = (header->magic == DICTXREFMAGIC && header->nrecs == d->nrecs);
+      MemHandleUnlock(h);
+    }
+
+  if (!good)
+    {
+      if (d->xrefref)
+	DmCloseDatabase(d->xrefref);
+      d->xrefref = NULL;
+      d->noxref = true;
+    }
+
+  return good;
+}
+
+
+
+/* Open the named dictionary for the session and get its first-word
+   index - from its app info block if it was built with one, or from
+   the sidecar DB if there's a good one there, or by reading the
+   dictionary (and then saving it) if not */
+Err DictOpen(dictType *d, const Char *name, const Char *sidecar)
+{
+  LocalID dbID, appInfo = 0;
+  UInt32 modified = 0;
+
+  DictClose(d);
+
+  dbID = DmFindDatabase(0, name);
+  if (!dbID)
+    return dmErrCantFind;
+
+  DmDatabaseInfo(0, dbID, NULL, NULL, NULL, NULL, NULL, NULL, &modified,
+		 &appInfo, NULL, NULL, NULL);
+
+  d->ref = DmOpenDatabase(0, dbID, dmModeReadOnly);
+  if (!d->ref)
+    return DmGetLastErr();
+
+  d->nrecs = DmNumRecords(d->ref);
+  d->modified = modified;
+  StrNCopy(d->name, name, MAXDBTITLE - 1);
+  d->name[MAXDBTITLE - 1] = '\0';
+
+  if (!DictLoadAppInfo(d, appInfo) && !DictLoadIndex(d, name, modified, sidecar))
+    {
+      if (DictBuildIndex(d, name, modified))
+	DictSaveIndex(d, sidecar);
+    }
+
+  return errNone;
+}
+
+
+
+void DictClose(dictType *d)
+{
+  UInt16 i;
+
+  for (i = 0; i < DICTTABLES; i++)
+    DictDropTable(&d->tables[i]);
+
+  if (d->indexh)
+    {
+      MemHandleUnlock(d->indexh);
+      MemHandleFree(d->indexh);
+    }
+
+  DictFreeUnpack(d);
+
+  if (d->sigref)
+    DmCloseDatabase(d->sigref);
+
+  if (d->xrefref)
+    DmCloseDatabase(d->xrefref);
+
+  if (d->ref)
+    DmCloseDatabase(d->ref);
+
+  d->ref = NULL;
+  d->indexh = NULL;
+  d->index = NULL;
+  d->nrecs = 0;
+  d->sigref = NULL;
+  d->nosigs = false;
+  d->xrefref = NULL;
+  d->noxref = false;
+}
+
+
+
+/* The first word of record rec.  Without an index it is read from the
+   record and is only good until the next call. */
+const Char *DictFirstWord(dictType *d, UInt16 rec)
+{
+  if (d->indexh)
+    return d->keys + d->offsets[rec];
+
+  DictReadFirstWord(d->ref, rec, d->probe);
+  return d->probe;
+}
+
+
+
+/* The record that word is in, if it's anywhere - the last record whose
+   first word doesn't sort after it (or the first record) */
+UInt16 DictFindRecord(dictType *d, const Char *word)
+{
+  UInt16 lo = 0, hi = d->nrecs, mid;
+
+  while (hi - lo > 1)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (StrCompare(DictFirstWord(d, mid), word) <= 0)
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  return lo;
+}
+
+
+
+/* Find word, or the entry that would follow it if it isn't there.
+   Returns false if it would come after the last entry. */
+Boolean DictFind(dictType *d, const Char *word, dictPosType *pos)
+{
+  dictTableType *t;
+  UInt16 lo, hi, mid;
+
+  if (d->nrecs == 0)
+    return false;
+
+  pos->rec = DictFindRecord(d, word);
+
+  t = DictTable(d, pos->rec);
+  if (!t)
+    return false;
+
+  /* The first entry that doesn't sort before word */
+  lo = 0;
+  hi = t->count;
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (DictRecCompare(word, t->words + t->keys[mid].word, t->keys[mid].wordlen) > 0)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  pos->entry = lo;
+
+  /* Past the end of the record it's the first word of the next one */
+  while (pos->entry >= t->count)
+    {
+      if (++pos->rec >= d->nrecs)
+	return false;
+
+      t = DictTable(d, pos->rec);
+      if (!t)
+	return false;
+      pos->entry = 0;
+    }
+
+  return true;
+}
+
+
+
+/* Move order[i] down the heap of the first n of order until it's no
+   smaller than what it's above */
+static void DictSiftDown(const Char **words, UInt16 *order, UInt16 i, UInt16 n)
+{
+  UInt16 top = order[i];
+  UInt32 child;
+
+  while ((child = 2 * i + 1) < n)
+    {
+      if (child + 1 < n && StrCompare(words[order[child + 1]], words[order[child]]) > 0)
+	child++;
+      if (StrCompare(words[order[child]], words[top]) <= 0)
+	break;
+      order[i] = order[child];
+      i = child;
+    }
+  order[i] = top;
+}
+
+
+
+/* Sort order, the numbers of n of words, into the words' order.  A
+   build-up card can have thousands of answers, longest first, so this
+   is a heapsort - it needs no more room and takes n log n compares
+   whatever order they come in. */
+static void DictSortWords(const Char **words, UInt16 *order, UInt16 n)
+{
+  UInt16 i, t;
+
+  if (n < 2)
+    return;
+
+  for (i = n / 2; i > 0; i--)
+    DictSiftDown(words, order, i - 1, n);
+
+  for (i = n - 1; i > 0; i--)
+    {
+      t = order[0];
+      order[0] = order[i];
+      order[i] = t;
+      DictSiftDown(words, order, 0, i);
+    }
+}
+
+
+
+/* Find each of the n words, setting found[i] and pos[i] for words[i].
+   The words are taken in sorted order so that the records and their
+   entries are gone through once from start to end - each record's table
+   is made at most once and the search in it starts where the last word
+   left off.  Returns the number found. */
+UInt16 DictFindAll(dictType *d, const Char **words, UInt16 n, dictPosType *pos,
+		   Boolean *found)
+{
+  dictTableType *t = NULL;
+  UInt16 *order, i, j, k, rec = 0, lo = 0, hi, mid, count = 0;
+
+  for (i = 0; i < n; i++)
+    found[i] = false;
+
+  if (d->nrecs == 0 || n == 0)
+    return 0;
+
+  order = MemPtrNew(n * sizeof(UInt16));
+  if (!order)
+    return 0;
+
+  for (i = 0; i < n; i++)
+    order[i] = i;
+  DictSortWords(words, order, n);
+
+  for (i = 0; i < n; i++)
+    {
+      k = order[i];
+
+      /* On to the word's record, if it's further on */
+      j = DictFindRecord(d, words[k]);
+      if (!t || j != rec)
+	{
+	  rec = j;
+	  lo = 0;
+	  t = DictTable(d, rec);
+	  if (!t)
+	    continue;
+	}
+
+      /* The first entry from lo on that doesn't sort before the word */
+      hi = t->count;
+      while (lo < hi)
+	{
+	  mid = lo + (hi - lo) / 2;
+	  if (DictRecCompare(words[k], t->words + t->keys[mid].word, t->keys[mid].wordlen) > 0)
+	    lo = mid + 1;
+	  else
+	    hi = mid;
+	}
+
+      if (lo < t->count
+	  && DictRecCompare(words[k], t->words + t->keys[lo].word, t->keys[lo].wordlen) == 0)
+	{
+	  pos[k].rec = rec;
+	  pos[k].entry = lo;
+	  found[k] = true;
+	  count++;
+	}
+    }
+
+  MemPtrFree(order);
+
+  return count;
+}
+
+
+
+/* The word at pos, as it is in the table - not terminated.  Unlike
+   DictGet() it unpacks nothing, so it needs no memory.  Returns false
+   if there isn't one. */
+Boolean DictWord(dictType *d, const dictPosType *pos, const Char **word, UInt16 *len)
+{
+  dictTableType *t;
+  const dictKeyType *k;
+
+  t = DictTable(d, pos->rec);
+  if (!t || pos->entry >= t->count)
+    return false;
+
+  k = &t->keys[pos->entry];
+  *word = t->words + k->word;
+  *len = k->wordlen;
+
+  return true;
+}
+
+
+
+/* The entry at pos.  Returns false if there isn't one. */
+Boolean DictGet(dictType *d, const dictPosType *pos, dictViewType *view)
+{
+  dictTableType *t;
+  const dictKeyType *k;
+
+  t = DictTable(d, pos->rec);
+  if (!t || pos->entry >= t->count)
+    return false;
+
+  k = &t->keys[pos->entry];
+  view->word = t->words + k->word;
+  view->wordlen = k->wordlen;
+
+  if (!t->packed)
+    {
+      view->def = t->text + k->def;
+      view->deflen = k->deflen;
+      return true;
+    }
+
+  /* Unpack the definition into a buffer kept for it */
+  if (!DictUnpackBuffer(d, k->rawlen))
+    return false;
+
+  view->def = d->unpack;
+  view->deflen = DictRecUnpack(t->text, k, d->unpack);
+
+  return true;
+}
+
+
+
+/* The entry at pos with its definition as it's shown - unpacked, "\n"
+   turned into newlines and ended by a NULL - for a field to show where
+   it is.  It's in the buffer for unpacked definitions, so it's good
+   until the next call that gets an entry.  Returns false if there isn't
+   the entry or the memory. */
+Boolean DictShow(dictType *d, const dictPosType *pos, dictViewType *view)
+{
+  dictTableType *t;
+  const dictKeyType *k;
+  const Char *s, *end;
+  Char *o;
+
+  t = DictTable(d, pos->rec);
+  if (!t || pos->entry >= t->count)
+    return false;
+
+  k = &t->keys[pos->entry];
+  view->word = t->words + k->word;
+  view->wordlen = k->wordlen;
+
+  /* It's never longer shown than it is in the record (or unpacked) */
+  if (!DictUnpackBuffer(d, (UInt32) (t->packed ? k->rawlen : k->deflen) + 1))
+    return false;
+
+  if (t->packed)
+    o = d->unpack + DictRecUnpack(t->text, k, d->unpack);
+  else
+    {
+      o = d->unpack;
+      s = t->text + k->def;
+      end = s + k->deflen;
+      while (s < end)
+	{
+	  if (s[0] == '\\' && s + 1 < end && s[1] == 'n')
+	    {
+	      *o++ = '\n';
+	      s += 2;
+	    }
+	  else
+	    *o++ = *s++;
+	}
+    }
+
+  *o = '\0';
+  view->def = d->unpack;
+  view->deflen = o - d->unpack;
+
+  return true;
+}
+
+
+
+/* Step pos on to the next entry, which is the first of the next record
+   at the end of this one.  Returns false (and leaves pos) at the end of
+   the dictionary. */
+Boolean DictNext(dictType *d, dictPosType *pos)
+{
+  dictTableType *t;
+  dictPosType next = *pos;
+
+  t = DictTable(d, next.rec);
+  if (!t)
+    return false;
+
+  next.entry++;
+  while (next.entry >= t->count)
+    {
+      if (++next.rec >= d->nrecs)
+	return false;
+
+      t = DictTable(d, next.rec);
+      if (!t)
+	return false;
+      next.entry = 0;
+    }
+
+  *pos = next;
+  return true;
+}
+
+
+
+/* Step pos back to the previous entry.  Returns false (and leaves pos)
+   at the start of the dictionary. */
+Boolean DictPrev(dictType *d, dictPosType *pos)
+{
+  dictTableType *t;
+  dictPosType prev = *pos;
+
+  while (prev.entry == 0)
+    {
+      if (prev.rec == 0)
+	return false;
+
+      prev.rec--;
+      t = DictTable(d, prev.rec);
+      if (!t)
+	return false;
+      prev.entry = t->count;
+    }
+
+  prev.entry--;
+
+  *pos = prev;
+  return true;
+}
+
+
+
+/* Find the first word at or after pos matching q.  Returns false at
+   the end of the dictionary.  To find the next match step pos on by an
+   entry - it can be left past the end of its record. */
+Boolean DictSearch(dictType *d, const searchQueryType *q, dictPosType *pos)
+{
+  dictTableType *t;
+  const dictKeyType *k;
+  const UInt32 *sigs;
+  MemHandle h;
+  UInt16 count;
+  Boolean found = false;
+
+  /* Without signatures every word is matched in full - slow but right */
+  DictOpenSigs(d);
+
+  for (; pos->rec < d->nrecs; pos->rec++, pos->entry = 0)
+    {
+      sigs = NULL;
+      count = 0;
+      h = d->sigref ? DmQueryRecord(d->sigref, pos->rec + 1) : NULL;
+      if (h)
+	{
+	  sigs = MemHandleLock(h);
+	  count = MemHandleSize(h) / sizeof(UInt32);
+
+	  /* Most records have nothing and needn't be read at all */
+	  while (pos->entry < count && !SearchMaybe(q, sigs[pos->entry]))
+	    pos->entry++;
+	  if (pos->entry >= count)
+	    {
+	      MemHandleUnlock(h);
+	      continue;
+	    }
+	}
+
+      t = DictTable(d, pos->rec);
+      if (t && sigs && count != (t->count ? t->count : 1))
+	sigs = NULL;    /* Doesn't belong to this record - ignore it */
+
+      for (; t && pos->entry < t->count; pos->entry++)
+	{
+	  if (sigs && !SearchMaybe(q, sigs[pos->entry]))
+	    continue;
+
+	  k = &t->keys[pos->entry];
+	  if (SearchMatch(q, t->words + k->word, k->wordlen))
+	    {
+	      found = true;
+	      break;
+	    }
+	}
+
+      if (h)
+	MemHandleUnlock(h);
+      if (found)
+	return true;
+    }
+
+  return false;
+}
+
+
+
+/* The word referred to at character at of the definition of the entry
+   at pos, from the cross-reference DB.  Returns false if there's
+   nothing there (or no cross-reference DB) and the word will have to
+   be looked up. */
+Boolean DictLink(dictType *d, const dictPosType *pos, UInt16 at, dictPosType *target)
+{
+  dictTableType *t;
+  MemHandle h;
+  UInt16 rec, entry;
+  Boolean found;
+
+  if (!DictOpenXref(d))
+    return false;
+
+  t = DictTable(d, pos->rec);
+  h = DmQueryRecord(d->xrefref, pos->rec + 1);
+  if (!t || !h)
+    return false;
+
+  found = DictRecLink(MemHandleLock(h), MemHandleSize(h), t->count, pos->entry,
+		      at, &rec, &entry);
+  MemHandleUnlock(h);
+
+  if (!found || rec >= d->nrecs)
+    return false;
+
+  target->rec = rec;
+  target->entry = entry;
+  return true;
+}
@@ -0,0 +1,154 @@
+/* The dictionary (lfdict).
+
+   Each record of the dictionary DB holds entries of a word and its
+   definition, separated and ended by tabs, in sorted order:
+
+       word<TAB>definition<TAB>word<TAB>definition ... NULL
+
+   To find a word we first need the record it's in.  That used to be a
+   binary search that opened the DB and read a record for every probe.
+   Now the DB is opened once and the first word of every record is
+   read into an index, so picking the record is a search in memory and
+   only the record holding the word is read.  Building the index means
+   reading every record, so it is saved as a record of lampflash.data
+   (the "sidecar") and read back from there while the dictionary is
+   unchanged.  A dictionary made by tools/mkdict comes with its index,
+   in the same form, in its app info block.
+
+   Within a record the words are found the same way.  The first time a
+   record is searched it is scanned once for where each word and
+   definition start, and the table is kept (with the record locked)
+   for the next few lookups.  A word is then a binary search of the
+   table comparing against the record in place, and what comes back is
+   a pointer and length into the record rather than a copy.  (A
+   packed record - see dictrec.h - has its words unpacked into the
+   table, and a definition is unpacked on its own when it's asked for.)
+
+   A dictPosType is a cursor - stepping it to the next or previous word
+   is a move along the table, and the two records either side of a
+   record boundary both keep their tables.
+
+   Pattern and anagram searches (see search.h) have to look at every
+   word, so that they don't have to read every record a second DB,
+   "<dictionary>-sigs", holds the signature of each word: record 0 is a
+   dictSigHeaderType and record i + 1 the UInt32 signatures of the
+   words of dictionary record i, in order.  It is made the first time
+   the dictionary is searched, which does read every record, and kept
+   until the dictionary changes.
+
+   If mkdict made a cross-reference DB, "<dictionary>-xref", with the
+   dictionary (see dictrec.h) then a word referred to in a definition
+   can be followed to where it's defined without searching for it. */
+
+#ifndef DICT_H
+#define DICT_H
+
+#include "dictrec.h"
+#include "search.h"
+
+/* Marks the sidecar record of the index */
+#define DICTINDEXMAGIC     'LFDX'
+
+/* dictIndexType - The first-word index.  The header is followed by an
+   offset into the keys for each record and then the keys, each ended
+   by a NULL.  It is held in memory and saved in exactly this form. */
+typedef struct
+{
+  Char          title[MAXDBTITLE];  /* Name of the dictionary - as for order records */
+  UInt32        magic;              /* DICTINDEXMAGIC */
+  UInt32        modified;           /* Modification number of the dictionary */
+  UInt16        nrecs;              /* Records in the dictionary */
+  UInt16        keysize;            /* Bytes of keys */
+} dictIndexType;
+
+/* Type of the signature DB, and what marks it as whole */
+#define DICTSIGTYPE        'Sigs'
+#define DICTSIGMAGIC       'LFDS'
+
+/* dictSigHeaderType - Record 0 of the signature DB.  The magic is only
+   written once every record is there. */
+typedef struct
+{
+  UInt32        magic;              /* DICTSIGMAGIC */
+  UInt32        modified;           /* Modification number of the dictionary */
+  UInt16        nrecs;              /* Records in the dictionary */
+} dictSigHeaderType;
+
+/* Records whose tables are kept */
+#define DICTTABLES          2
+
+/* dictTableType - The entries of a record */
+typedef struct
+{
+  UInt16        rec;
+  UInt32        used;      /* Clock when last used, for LRU */
+  MemHandle     rech;      /* The record, locked while the table is kept, or NULL */
+  const Char   *text;      /* ... locked */
+  MemHandle     keysh;     /* The table, and for a packed record the words after it */
+  dictKeyType  *keys;      /* ... locked */
+  const Char   *words;     /* What the keys' words are offsets into */
+  Boolean       packed;
+  UInt16        count;     /* Entries in the record */
+} dictTableType;
+
+/* dictPosType - An entry of the dictionary */
+typedef struct
+{
+  UInt16        rec;
+  UInt16        entry;
+} dictPosType;
+
+/* dictViewType - An entry as it is in the record, or for a packed
+   record with the definition unpacked.  Nothing is terminated and it's
+   only good until the next call that finds or gets an entry. */
+typedef struct
+{
+  const Char   *word;
+  UInt16        wordlen;
+  const Char   *def;
+  UInt16        deflen;
+} dictViewType;
+
+/* dictType - The open dictionary */
+typedef struct
+{
+  DmOpenRef      ref;      /* NULL when not open */
+  UInt16         nrecs;    /* Number of records */
+  Char           name[MAXDBTITLE];
+  UInt32         modified;
+  MemHandle      indexh;   /* The index, or NULL if we couldn't make one */
+  dictIndexType *index;    /* ... locked */
+  UInt16        *offsets;  /* Offset of the key of each record */
+  Char          *keys;
+  Char           probe[MAXDBTITLE + 1];  /* First word read without an index */
+
+  UInt32         clock;
+  dictTableType  tables[DICTTABLES];
+
+  MemHandle      unpackh;  /* Definition last unpacked or shown */
+  Char          *unpack;   /* ... locked */
+  UInt32         unpacksize;
+
+  DmOpenRef      sigref;   /* The signature DB once it's needed, or NULL */
+  Boolean        nosigs;   /* ... and it couldn't be had */
+
+  DmOpenRef      xrefref;  /* The cross-reference DB once it's needed, or NULL */
+  Boolean        noxref;   /* ... and there isn't a good one */
+} dictType;
+
+Err         DictOpen(dictType *d, const Char *name, const Char *sidecar);
+void        DictClose(dictType *d);
+const Char *DictFirstWord(dictType *d, UInt16 rec);
+UInt16      DictFindRecord(dictType *d, const Char *word);
+Boolean     DictFind(dictType *d, const Char *word, dictPosType *pos);
+UInt16      DictFindAll(dictType *d, const Char **words, UInt16 n, dictPosType *pos,
+			Boolean *found);
+Boolean     DictWord(dictType *d, const dictPosType *pos, const Char **word, UInt16 *len);
+Boolean     DictGet(dictType *d, const dictPosType *pos, dictViewType *view);
+Boolean     DictShow(dictType *d, const dictPosType *pos, dictViewType *view);
+Boolean     DictNext(dictType *d, dictPosType *pos);
+Boolean     DictPrev(dictType *d, dictPosType *pos);
+Boolean     DictSearch(dictType *d, const searchQueryType *q, dictPosType *pos);
+Boolean     DictLink(dictType *d, const dictPosType *pos, UInt16 at, dictPosType *target);
+
+#endif
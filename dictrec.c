@@ -0,0 +1,275 @@
+/* -----------------------------------------------------------------------------
+   Dictionary record formats for LAMPFlash.
+
+   Packed records are read a byte at a time - their 16-bit fields are
+   big-endian and unaligned - so the same code reads them on the Palm
+   and in the host tools.  A damaged packed record is read as far as it
+   makes sense and no further.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "dictrec.h"
+
+
+#define DictRecWord(p)      ((UInt16) (((p)[0] << 8) | (p)[1]))
+
+
+
+Boolean DictRecIsPacked(const void *rec, UInt32 size)
+{
+  const UInt8 *r = rec;
+
+  return (size >= sizeof(dictPackHeaderType) && r[0] == DICTPACKMAGIC
+	  && r[1] == DICTPACKVERSION);
+}
+
+
+
+/* The entries of a plain record */
+static UInt16 DictRecScanPlain(const Char *text, UInt32 size, dictKeyType *keys)
+{
+  UInt16 i = 0, n = 0, start;
+
+  if (size > 0xFFFF)
+    size = 0xFFFF;
+
+  while (i < size && text[i] != '\0')
+    {
+      start = i;
+      while (i < size && text[i] != '\0' && text[i] != '\t')
+	i++;
+      if (keys)
+	{
+	  keys[n].word = start;
+	  keys[n].wordlen = i - start;
+	}
+
+      if (i < size && text[i] == '\t')
+	i++;
+
+      start = i;
+      while (i < size && text[i] != '\0' && text[i] != '\t')
+	i++;
+      if (keys)
+	{
+	  keys[n].def = start;
+	  keys[n].deflen = keys[n].rawlen = i - start;
+	}
+
+      if (i < size && text[i] == '\t')
+	i++;
+      n++;
+    }
+
+  return n;
+}
+
+
+
+/* The entries of a packed record, unpacking the words into words.
+   Offsets are worked out in 32 bits so that a damaged length can't
+   wrap them back into the record; an entry that doesn't fit in it
+   whole ends the scan. */
+static UInt16 DictRecScanPacked(const UInt8 *r, UInt32 size, dictKeyType *keys,
+				Char *words, UInt16 *wordsize)
+{
+  UInt16 count = DictRecWord(r + 2);
+  UInt16 n, prefix, suffix, deflen, prev = 0, len = 0;
+  UInt32 i, w = 0;
+
+  if (size > 0xFFFF)
+    size = 0xFFFF;
+  if (DictRecWord(r + 4) < size)
+    size = DictRecWord(r + 4);
+
+  i = sizeof(dictPackHeaderType) + 2 * (UInt32) DictRecWord(r + 6);
+
+  for (n = 0; n < count && i + 2 <= size; n++)
+    {
+      prefix = r[i];
+      suffix = r[i + 1];
+      if (prefix > len || i + 6 + suffix > size)
+	break;
+
+      deflen = DictRecWord(r + i + 2 + suffix);
+      if (i + 6 + suffix + deflen > size || w + prefix + suffix > 0xFFFF)
+	break;
+
+      if (keys)
+	{
+	  /* The shared part is at the end of the words so far */
+	  MemMove(words + w, words + prev, prefix);
+	  MemMove(words + w + prefix, r + i + 2, suffix);
+	  keys[n].word = w;
+	  keys[n].wordlen = prefix + suffix;
+	}
+      prev = w;
+      len = prefix + suffix;
+      w += len;
+      i += 2 + suffix;
+
+      if (keys)
+	{
+	  keys[n].deflen = deflen;
+	  keys[n].rawlen = DictRecWord(r + i + 2);
+	  keys[n].def = i + 4;
+	}
+      i += 4 + deflen;
+    }
+
+  if (wordsize)
+    *wordsize = w;
+
+  return n;
+}
+
+
+
+/* Find the entries of the record rec of size bytes and return how many
+   there are.  If keys isn't NULL it is filled in, and for a packed
+   record the words are unpacked into words, which must have room for
+   the *wordsize bytes the call without keys said were needed. */
+UInt16 DictRecScan(const void *rec, UInt32 size, dictKeyType *keys,
+		   Char *words, UInt16 *wordsize)
+{
+  if (DictRecIsPacked(rec, size))
+    return DictRecScanPacked(rec, size, keys, words, wordsize);
+
+  if (wordsize)
+    *wordsize = 0;
+
+  return DictRecScanPlain(rec, size, keys);
+}
+
+
+
+/* Copy the first word of the record to word, at most max bytes, and
+   terminate it.  Returns its length. */
+UInt16 DictRecFirstWord(const void *rec, UInt32 size, Char *word, UInt16 max)
+{
+  const UInt8 *r = rec;
+  const Char *s = rec;
+  UInt16 i, n = 0;
+
+  if (DictRecIsPacked(rec, size))
+    {
+      /* The first word has nothing in common with anything before it */
+      i = sizeof(dictPackHeaderType) + 2 * DictRecWord(r + 6);
+      if (DictRecWord(r + 2) > 0 && i + 2 <= size && r[i] == 0)
+	{
+	  for (n = 0; n < r[i + 1] && n < max && i + 2 + n < size; n++)
+	    word[n] = r[i + 2 + n];
+	}
+    }
+  else
+    {
+      while (n < size && n < max && s[n] != '\0' && s[n] != '\t')
+	{
+	  word[n] = s[n];
+	  n++;
+	}
+    }
+  word[n] = '\0';
+
+  return n;
+}
+
+
+
+/* Unpack the definition of key into out, which needs room for
+   key->rawlen bytes (it isn't terminated).  A plain definition is just
+   copied.  Returns the number of bytes written. */
+UInt16 DictRecUnpack(const void *rec, const dictKeyType *key, Char *out)
+{
+  const UInt8 *r = rec;
+  const UInt8 *s = r + key->def;
+  const UInt8 *end = s + key->deflen;
+  const UInt8 *pairs;
+  UInt8 stack[DICTPAIRDEPTH];
+  UInt16 n = 0, depth, pairc;
+  UInt8 c;
+
+  if (r[0] != DICTPACKMAGIC)
+    {
+      MemMove(out, s, key->deflen);
+      return key->deflen;
+    }
+
+  pairs = r + sizeof(dictPackHeaderType);
+  pairc = DictRecWord(r + 6);
+
+  for (; s < end; s++)
+    {
+      stack[0] = *s;
+      depth = 1;
+
+      /* Expand the code depth first, the second of each pair waiting on
+	 the stack under the first */
+      while (depth > 0 && n < key->rawlen)
+	{
+	  c = stack[--depth];
+	  if (c < DICTPAIRBASE)
+	    out[n++] = c;
+	  else if (c - DICTPAIRBASE < pairc && depth + 2 <= DICTPAIRDEPTH)
+	    {
+	      stack[depth++] = pairs[2 * (c - DICTPAIRBASE) + 1];
+	      stack[depth++] = pairs[2 * (c - DICTPAIRBASE)];
+	    }
+	}
+    }
+
+  return n;
+}
+
+
+
+/* Compare word with the len bytes of s, as StrCompare() would for the
+   dictionary's lowercase words */
+Int16 DictRecCompare(const Char *word, const Char *s, UInt16 len)
+{
+  UInt16 i;
+
+  for (i = 0; i < len && word[i] != '\0'; i++)
+    if (word[i] != s[i])
+      return (UInt8) word[i] < (UInt8) s[i] ? -1 : 1;
+
+  if (i < len)
+    return -1;
+
+  return (word[i] == '\0') ? 0 : 1;
+}
+
+
+
+/* Look in the cross-reference record xref (of size bytes) for entry's
+   reference covering character at of its definition.  count is the
+   entries of the dictionary record, to check the two go together.
+   Returns false if there is no such reference. */
+Boolean DictRecLink(const void *xref, UInt32 size, UInt16 count, UInt16 entry,
+		    UInt16 at, UInt16 *rec, UInt16 *target)
+{
+  const UInt8 *x = xref, *r;
+  UInt16 i, end;
+
+  if (size < 2 || DictRecWord(x) != count || entry >= count
+      || size < 2 + 2 * ((UInt32) count + 1))
+    return false;
+
+  i = DictRecWord(x + 2 + 2 * entry);
+  end = DictRecWord(x + 2 + 2 * (entry + 1));
+  for (; i < end; i++)
+    {
+      r = x + 2 + 2 * (count + 1) + (UInt32) i * DICTXREFREF;
+      if (r + DICTXREFREF > x + size)
+	break;
+
+      if (at >= DictRecWord(r) && at < DictRecWord(r) + DictRecWord(r + 2))
+	{
+	  *rec = DictRecWord(r + 4);
+	  *target = DictRecWord(r + 6);
+	  return true;
+	}
+    }
+
+  return false;
+}
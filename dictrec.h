@@ -0,0 +1,97 @@
+/* The record formats of the dictionary.
+
+   A plain record is the text it has always been:
+
+       word<TAB>definition<TAB>word<TAB>definition ... NULL
+
+   with newlines in the definitions written as "\n".
+
+   A packed record starts with a dictPackHeaderType (the first byte,
+   DICTPACKMAGIC, can't start a word) followed by the pair table and
+   then the entries:
+
+       UInt8    prefix     bytes shared with the word before
+       UInt8    suffixlen
+       Char     suffix[suffixlen]
+       UInt8    deflen[2]  packed bytes of definition, big-endian
+       UInt8    rawlen[2]  ... and once unpacked
+       UInt8    def[deflen]
+
+   The words are front-coded - each keeps only what differs from the
+   word before it.  The definitions are byte-pair coded: definition text
+   is 7-bit and newlines are real newlines, so bytes 0x80 to 0xFF are
+   free to stand for a pair of bytes (each of which may be another
+   pair) from the record's pair table.  One definition unpacks on its
+   own, without the rest of the record.
+
+   A dictionary can come with a cross-reference DB made by mkdict -x,
+   with a record for each record of the dictionary (after record 0, a
+   dictXrefHeaderType) listing where the words its definitions refer to
+   are:
+
+       UInt8    count[2]         entries in the dictionary record
+       UInt8    first[count+1][2]  each entry's first reference, and the end
+       UInt8    ref[][8]         at[2] len[2] rec[2] entry[2]
+
+   at and len are where the word is in the definition as it's shown
+   (newlines as one character), and rec and entry where it's defined.
+   Everything is big-endian, read a byte at a time.
+
+   Nothing here touches the Data Manager so the tools can use it too. */
+
+#ifndef DICTREC_H
+#define DICTREC_H
+
+#define DICTPACKMAGIC      0x02
+#define DICTPACKVERSION       1
+
+/* Codes 0x80 to 0xFF */
+#define DICTPAIRS           128
+#define DICTPAIRBASE       0x80
+
+/* Pairs are only followed this deep - the builder doesn't go deeper */
+#define DICTPAIRDEPTH        32
+
+/* dictPackHeaderType - Start of a packed record */
+typedef struct
+{
+  UInt8         magic;     /* DICTPACKMAGIC */
+  UInt8         version;   /* DICTPACKVERSION */
+  UInt16        count;     /* Entries */
+  UInt16        size;      /* Bytes of the record used */
+  UInt16        pairs;     /* Pairs in the table, two bytes each */
+} dictPackHeaderType;
+
+/* Marks record 0 of the cross-reference DB */
+#define DICTXREFMAGIC      'LFDR'
+#define DICTXREFREF           8   /* Bytes of a reference */
+
+/* dictXrefHeaderType - Record 0 of the cross-reference DB */
+typedef struct
+{
+  UInt32        magic;     /* DICTXREFMAGIC */
+  UInt16        nrecs;     /* Records in the dictionary */
+} dictXrefHeaderType;
+
+/* dictKeyType - Where an entry of a record is.  The definition is an
+   offset into the record.  The word is an offset into the record too
+   for a plain record, and into the unpacked words for a packed one. */
+typedef struct
+{
+  UInt16        word;
+  UInt16        wordlen;
+  UInt16        def;
+  UInt16        deflen;    /* Bytes in the record */
+  UInt16        rawlen;    /* ... and unpacked */
+} dictKeyType;
+
+Boolean DictRecIsPacked(const void *rec, UInt32 size);
+UInt16  DictRecScan(const void *rec, UInt32 size, dictKeyType *keys,
+		    Char *words, UInt16 *wordsize);
+UInt16  DictRecFirstWord(const void *rec, UInt32 size, Char *word, UInt16 max);
+UInt16  DictRecUnpack(const void *rec, const dictKeyType *key, Char *out);
+Int16   DictRecCompare(const Char *word, const Char *s, UInt16 len);
+Boolean DictRecLink(const void *xref, UInt32 size, UInt16 count, UInt16 entry,
+		    UInt16 at, UInt16 *rec, UInt16 *target);
+
+#endif
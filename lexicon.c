@@ -0,0 +1,94 @@
+/* -----------------------------------------------------------------------------
+   Opening the lexicon DB for LAMPFlash.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "lexicon.h"
+
+
+
+/* Open the named lexicon and lock its records.  Any lexicon already
+   open is closed first. */
+Err LexiconOpen(lexiconType *l, const Char *name)
+{
+  LocalID dbID;
+  UInt32 type;
+  UInt16 i, nrecs;
+  MemHandle h;
+
+  LexiconClose(l);
+
+  dbID = DmFindDatabase(0, name);
+  if (!dbID)
+    return dmErrCantFind;
+
+  if (DmDatabaseInfo(0, dbID, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+		     NULL, NULL, &type, NULL) != errNone || type != LEXICONDBTYPE)
+    return dmErrCantFind;
+
+  l->ref = DmOpenDatabase(0, dbID, dmModeReadOnly);
+  if (!l->ref)
+    return DmGetLastErr();
+
+  /* The header says how many records of edges there should be */
+  nrecs = DmNumRecords(l->ref);
+  h = nrecs ? DmQueryRecord(l->ref, 0) : NULL;
+  if (!h || !DawgInit(&l->dawg, MemHandleLock(h), MemHandleSize(h))
+      || l->dawg.nrecs + 1 > nrecs)
+    {
+      if (h)
+	MemHandleUnlock(h);
+      DmCloseDatabase(l->ref);
+      l->ref = NULL;
+      return dmErrCorruptDatabase;
+    }
+
+  l->h = MemPtrNew((l->dawg.nrecs + 1) * sizeof(MemHandle));
+  l->dawg.rec = MemPtrNew(l->dawg.nrecs * sizeof(const UInt8 *));
+  if (!l->h || !l->dawg.rec)
+    {
+      MemHandleUnlock(h);
+      if (l->h)
+	MemPtrFree(l->h);
+      l->h = NULL;
+      LexiconClose(l);
+      return memErrNotEnoughSpace;
+    }
+
+  l->h[0] = h;
+  l->nh = 1;
+  for (i = 0; i < l->dawg.nrecs; i++)
+    {
+      h = DmQueryRecord(l->ref, i + 1);
+      if (!h)
+	{
+	  LexiconClose(l);
+	  return dmErrCorruptDatabase;
+	}
+      l->dawg.rec[i] = MemHandleLock(h);
+      l->h[l->nh++] = h;
+    }
+
+  return errNone;
+}
+
+
+
+void LexiconClose(lexiconType *l)
+{
+  UInt16 i;
+
+  if (l->h)
+    {
+      for (i = 0; i < l->nh; i++)
+	MemHandleUnlock(l->h[i]);
+      MemPtrFree(l->h);
+    }
+  if (l->dawg.rec)
+    MemPtrFree((MemPtr) l->dawg.rec);
+  if (l->ref)
+    DmCloseDatabase(l->ref);
+
+  MemSet(l, sizeof(lexiconType), 0);
+}
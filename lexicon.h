@@ -0,0 +1,29 @@
+/* The lexicon DB, open.
+
+   "lflex" is made on the host by tools/mkdawg from a word list (see
+   dawg.h for what's in it).  It's opened read-only and all its records
+   are locked for as long as it's open, so a lookup is no more than a
+   walk through memory.  Without it LAMPFlash does what it always has -
+   hooks come from the deck. */
+
+#ifndef LEXICON_H
+#define LEXICON_H
+
+#include "dawg.h"
+
+#define LEXICONDB          "lflex"
+#define LEXICONDBTYPE      'Dawg'
+
+/* lexiconType - The open lexicon */
+typedef struct
+{
+  DmOpenRef     ref;       /* NULL if not open */
+  MemHandle    *h;         /* The records locked, header first */
+  UInt16        nh;
+  dawgType      dawg;
+} lexiconType;
+
+Err     LexiconOpen(lexiconType *l, const Char *name);
+void    LexiconClose(lexiconType *l);
+
+#endif
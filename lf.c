@@ -13,15 +13,20 @@
 #include <PalmChars.h>
 #include <PalmNavigator.h>
 #include "lf.h"
+#include "rand.h"
+#include "quiz.h"
+#include "card.h"
+#include "deck.h"
+#include "rack.h"
+#include "dict.h"
+#include "search.h"
+#include "defcache.h"
+#include "lexicon.h"
 
 
 /* GLOBAL CONSTANTS */
 
 
-/* My creator ID is registered with Palm via Access - see the website
-   (http://www.access-company.com/developers/index.html) */
-#define CREATORID        'shLF'   
-
 /* PDB databases should be of this type - case sensitive! */
 #define DBTYPE           'DATA'
 
@@ -31,39 +36,26 @@
 
 /* Update the version numbers whenever we redefine the prefs and state
  * structures otherwise we read garbage. */
-#define PREFSVERSION         15
-#define STATEVERSION         18
-
-/* NOTE - if you change MAXDBTITLE you will alter the size of the prefs structure
-   and so the prefs version number must be incremented. */
-#define MAXDBTITLE          32  
+#define PREFSVERSION         17
+#define STATEVERSION         20
 
 /* Allocate memory to display this many DBs - more memory is
    allocated as needed. */
 #define INITNODBS           20
 
-/* This program is designed with a maximum length of flashcard 
-   in mind.  The size of the screen and letters determines this. */
-#define MAXWORDLENGTH       9
-
-/* This value is arbitrary and defines the size of the buffers 
-   used to store the front and back hooks.  Should be sufficient as
-   surely no word has more than 20 front or back hooks. */
-#define MAXNOHOOKS          20
-
 /* Directional constants used in scrolling the DB list */
 #define NONE                 0
 #define DOWN                 1
 #define UP                  -1
 
-/* Tile and rack dimensions and positions */
-#define YOFFSET             22
-#define TILEWIDTH           16 
-#define TILEHEIGHT          17
-#define TILESPACE            2
+/* Bytes of search results shown at a time */
+#define SEARCHPAGESIZE     500
+
+/* Pages of search results that Prev can go back through */
+#define SEARCHPAGES        100
 
-/* no definition should be longer than this. */
-#define MAXDEFLENGTH       500
+/* Entries Back can return to */
+#define HISTORYSIZE         16
 
 
 
@@ -74,33 +66,43 @@
 
 
 
-/* dbOrderType - Quiz order data associated with a DB. */
+/* Marks a quiz order record written in the format below */
+#define ORDERMAGIC       'LFQ3'
+
+/* dbOrderType - Quiz order data associated with a DB.  The order itself
+   isn't saved, only the seed it was dealt from and how far the quiz has
+   drawn into it.  The header is followed by the card bits of the deck
+   (total bits) and the shown bits of the deal (size bits). */
 typedef struct
 {
   Char       title[MAXDBTITLE];
-  UInt16     total;
-  UInt16     visible;
-  Int16      order[MAXNOFLASHCARDS];   
+  UInt32     magic;    /* ORDERMAGIC */
+  UInt32     total;    /* Number of cards in the deck */
+  UInt32     size;     /* Number of cards in the current deal */
+  UInt32     seed;     /* Seed of the current deal */
+  UInt32     cursor;   /* Positions of the deal drawn so far */
 } dbOrderType;
 
 
-/* dbTitleType - Holds a DB title and is used in displaying the DB list. */
+/* dbLegacyOrderType - Quiz order records written by older versions.
+   They hold the whole order, 1-based and negative when hidden, and are
+   converted when read. */
+#define LEGACYMAXCARDS  250
+
 typedef struct
 {
-  Char     title[MAXDBTITLE];
-} dbTitleType;
+  Char       title[MAXDBTITLE];
+  UInt16     total;
+  UInt16     visible;
+  Int16      order[LEGACYMAXCARDS];   
+} dbLegacyOrderType;
 
 
-/* wordListType - Holds the current flashcard data (answers count, the
-   words, and the hooks).  NOTE - the flashcard is stored separately in
-   flashcard. */
+/* dbTitleType - Holds a DB title and is used in displaying the DB list. */
 typedef struct
 {
-  UInt16        count;  /* Number of answers to the current flashcard */
-  Char          words[MAXDISPLAYSIZE][MAXWORDLENGTH + 1];
-  Char          front[MAXDISPLAYSIZE][MAXNOHOOKS + 1];  
-  Char          back[MAXDISPLAYSIZE][MAXNOHOOKS + 1];   
-} wordListType;
+  Char     title[MAXDBTITLE];
+} dbTitleType;
 
 
 /* prefsType - The system preferences. */
@@ -110,20 +112,23 @@ typedef struct
   UInt8         letterorder; /* Default letter order of the flashcard */
   UInt8         showhooks;   /* Display hooks where available? */
   UInt8         showtiles;   /* Show tiles or just write the flashcard string? */
+  UInt8         prefetchdefs; /* Find the answers in the dictionary as each card loads? */
+  UInt8         buildup;     /* Ask for every word the rack makes, from the lexicon? */
 } prefsType;
 
 
 /* stateType - The current state data. */
 typedef struct
 {
-  UInt16  dbcurrec;  /* Record number of the current question */
+  UInt32  dbcurrec;  /* Record number of the current question */
   Char    dbname[MAXDBTITLE]; /* Title of the current database */
-  UInt16  total; /* The number of records in the DB */
-  UInt16  seen; /* Current flashcard number as displayed (not curr) */
-  UInt16  visible; /* Total number of visible flashcards (un-hidden ones) */ 
-  UInt16  curr; /* Record number of the current flashcard (not seen) */
-  Int16   order[MAXNOFLASHCARDS]; /* Order values */
+  UInt32  total; /* The number of records in the DB */
+  UInt32  seen; /* Position of the current flashcard in the quiz order (not curr) */
+  UInt32  visible; /* Total number of visible flashcards (un-hidden ones) */ 
+  UInt32  curr; /* Current flashcard number as displayed (not seen) */
   UInt16  noCurrDB; /* The number of the current database */
+  UInt32  seed; /* Seed the random numbers of this quiz were started from */
+  rngType rng; /* Random number generator - deals and rack shuffles */
 } stateType;
 
 
@@ -131,8 +136,10 @@ typedef struct
 static FormPtr      pCurForm = NULL; 
 
 /* Pointers to the word list - needed to display the list of 
-   answers and to make the scroll bar work. */
-static Char         *pMainWordListPtrArray[MAXDISPLAYSIZE];
+   answers and to make the scroll bar work.  There's one more than
+   there are answers, for the clue row.  An answer's row points at the
+   answer itself; it's formatted as it's drawn. */
+static Char         **pMainWordListPtrArray;
 
 
 /* The flashcard string - this can be manipulated by shuffling. */
@@ -140,15 +147,46 @@ static Char         flashcard[MAXWORDLENGTH + 1];
 /* Buffer to hold the alphagram of the flashcard */
 static Char         alphagram[MAXWORDLENGTH + 1];
 /* The quiz data associated with the flashcard - answers count,
-   answers and hooks */ 
-static wordListType flash;
+   answers and hooks.  This is the card in the deck cache, which is
+   kept for us until we ask the deck for another. */ 
+static const cardType *flash = &cardNone;
+
+/* The current card as a build-up card, when prefs.buildup is set and
+   there's a lexicon to find its answers in */
+static cardType      buildup;
+
+/* The card shown when there isn't the memory for all of its answers -
+   as many of them as there is */
+static cardType      trimmed;
 
-static Char         display[MAXDISPLAYSIZE][40 + 1];  /* flashwords */
+/* Answers there's room for below - the arrays that go with each answer
+   are allocated for the card with the most answers yet, and kept */
+static UInt16        answerroom;
+
+/* Room for at least this many answers is made at a time */
+#define ANSWERROOM          32
+
+/* An answer, a small space and its hooks - "EON  lp-s" */
+#define MAXLINELENGTH      (MAXWORDLENGTH + 2 + MAXNOHOOKS + 1 + MAXNOHOOKS)
+
+/* The letters of the next answer shown as a clue */
+static Char         cluetxt[MAXWORDLENGTH + 1];
+
+/* Whether hooks were shown when the list was last drawn */
+static UInt8        formattedhooks;
+
+/* What the answers list shows - answers, clue letters and whether it
+   can be drawn a row at a time from here */
+static UInt16       listmax;
+static UInt16       listclues;
+static Boolean      listvalid = false;
 
 /* Buffers to hold the text on the Prefs form pull-down menus */  
 static Char         countertxt[5];    
 static Char         hookstxt[5];    
 static Char         showtilestxt[5];  
+static Char         prefetchtxt[5];
+static Char         builduptxt[5];
 static Char         *counteropts[2] = { "No", "Yes" };
 
 
@@ -200,8 +238,8 @@ static UInt16       lastID;
    Cannot be null so it contains some arbitrary text initially. */
 static Char          nextDBhighlight[MAXDBTITLE] = "a\0";
 
-/* Define the array of rectangles that define the flashcard tiles. */
-static RectangleType rack[8]; /* or rack pointer */
+/* The flashcard tiles on screen. */
+static rackType      rack;
 
 /* Indicates which tile is highlighted in the rack (if none is 
    selected is should be set to -1. */
@@ -221,12 +259,73 @@ static UInt32        dblistsize;
 static stateType     state;
 static prefsType     prefs;
 
+/* Order and hidden flags of the current quiz.  Saved to lampflash.data
+   rather than with the state as it can be any size. */
+static quizType      quiz;
+
+/* The flashcard DB of the current quiz, held open while the quiz runs */
+static deckType      deck;
+
+/* Read ahead of the current card - the position of the last card read
+   ahead and how many have been read since the card was shown */
+static UInt32        aheadpos;
+static UInt16        aheadcount;
+
 
 /* Dictionary word for looking up. */
 static Char lookup[MAXDBTITLE + 1];           /* words can be up to 32 characters */
-static Char firstword[MAXDBTITLE + 1];
-static Char definition[MAXDEFLENGTH+1];
-static UInt16 lookuprec, lookupoffset;
+
+/* The Dict form's text field shows definitions where they are - in the
+   dictionary's buffer or the lookup cache - rather than a copy.  Pages
+   of search results are put together here. */
+static Char pagetext[SEARCHPAGESIZE + 1];
+static Char notfound[] = "Not found.";
+
+/* Where the word shown is, if lookupvalid - Next and Prev step on from
+   here rather than searching again */
+static dictPosType lookuppos;
+static Boolean lookupvalid;
+
+/* The dictionary, held open once a word has been looked up */
+static dictType dict;
+
+/* Recent lookups, ready to show again */
+static defCacheType defcache;
+
+/* Where the current card's answers are in the dictionary, if
+   prefs.prefetchdefs - found together as the card loads so that
+   tapping one needs no search.  lookupready says lookuppos has been
+   set that way for the Dict form to show. */
+static Char (*answerwords)[MAXWORDLENGTH + 1];
+static const Char **answerptrs;
+static dictPosType *answerpos;
+static Boolean *answerfound;
+static Boolean lookupready;
+
+/* Set when the dictionary couldn't be opened for a prefetch, so that
+   it isn't tried again for every card */
+static Boolean nodictionary;
+
+/* The lexicon, if there is one - opened the first time hooks are
+   wanted and kept open.  nolexicon is set when it can't be, so that
+   decks without stored hooks don't try again for every answer. */
+static lexiconType lexicon;
+static Boolean nolexicon;
+
+/* A pattern or anagram search, if searching - the page of matches
+   shown and where each page up to it started.  Next and Prev page
+   through the matches instead of stepping through the dictionary. */
+static searchQueryType query;
+static Boolean searching;
+static dictPosType searchpages[SEARCHPAGES + 1];
+static UInt16 searchpage;
+static Boolean searchmore;
+
+/* Entries jumped away from, latest at history[historytop - 1] going
+   round - the oldest are forgotten when it's full */
+static dictPosType history[HISTORYSIZE];
+static UInt16 historytop;
+static UInt16 historycount;
 
 
 
@@ -269,6 +368,10 @@ static ControlPtr     pPrefsHooksTrig = NULL;
 static ListPtr        pPrefsHooksList = NULL;
 static ControlPtr     pPrefsShowTilesTrig = NULL;
 static ListPtr        pPrefsShowTilesList = NULL;
+static ControlPtr     pPrefsPrefetchTrig = NULL;
+static ListPtr        pPrefsPrefetchList = NULL;
+static ControlPtr     pPrefsBuildUpTrig = NULL;
+static ListPtr        pPrefsBuildUpList = NULL;
 
 /* Database form */
 
@@ -288,15 +391,21 @@ static FieldPtr       pDBDeleteName = NULL;
 
 
 /* These are listed here in the order they appear in this file */
-static void SearchRecordByScroll(UInt8 dir);
+static const Char *ShowDefinition(void);
+static void StepDefinition(Int8 dir);
+static Boolean OpenDictionary(void);
+static void SearchDictionary(void);
+static void ShowSearchPage(void);
+static void JumpToSelection(UInt16 hstart, UInt16 hend);
+static void PushHistory(void);
+static void BackDefinition(void);
+static void PrefetchDefinitions(void);
 
 
 static void DisplayLookupWord(Char *word);
 static void CleanUpString(Char *str);
 
 static void LookupDefinition(Char *word);
-static UInt16 SearchRecordForWord(DmOpenRef dbref, UInt16 id);
-static void ReadFirstWordInRecord(DmOpenRef dbref, UInt16 id);
 
 
 
@@ -318,6 +427,8 @@ static void CleanUpDBPointers(void);
 
 /* Save Order Data */
 static void    SaveOrderData(void);
+static Boolean LoadOrderData(void);
+static void    RemoveOrderData(DmOpenRef dbRef, Char *title);
 
 /* Card delete functions */
 static void    UndeleteAll(void);
@@ -336,27 +447,34 @@ static void    WordDBScroll(Int8 dir);
 static void    SortByName(dbTitleType **x, UInt16 first, UInt16 last);
 static UInt16  PartitionByName(dbTitleType **y, UInt16 f, UInt16 l);
 static void    SetWordOrder();
+static void    FormatAnswer(UInt16 d, Char *line);
+static void    DrawAnswerRow(Int16 item, RectangleType *bounds, Char **text);
+static void    DrawAnswerListRow(UInt16 item, UInt16 top);
+static void    ScrollAnswerList(UInt16 item, UInt16 top);
 static void    ShowAnswers(UInt16 max, UInt16 clues);
 static void    DoNext(void);
 static void    DoLast(void);
 
 static void    ClearFlashField(void);
-static void    DrawTile(RectangleType rec, Char c, UInt8 border);
-static void    SetUpFlashcardField(void);
 static void    SetFlashField();
-static void    SetFlashNumber(UInt16);
+static void    SetFlashNumber(UInt32);
 static void    OrderNewFlashcard(void);
 static void    RandomiseFlashcard(void);
 static void    VowConiseFlashcard(void);
 static void    AlphagramiseFlashcard(void);
+static void    DefaultStats(void);
 static void    ResetStats(void);
 static void    ReorderFlashcards(void);
 static Err     FindAllWordDBs(void);                /* check return codes */ 
 static void    ShowWordDBs(void);
 static Err     CountRecordsInDB(void);
-static UInt16  RandomNum(UInt16 n);
+static UInt32  NewSeed(void);
+static UInt32  NextSeed(void);
 static void    SetField(FieldPtr field, Char* text, UInt16 memsize);
 static void    GetNewFlashcard(void);
+static Boolean PrefetchPending(void);
+static void    PrefetchNextCard(void);
+static void    ShowCacheStats(void);
 static void    SetCounter(UInt16 c);
 
 static void    InitMainForm(void);
@@ -380,77 +498,41 @@ UInt32         PilotMain(UInt16 cmd, MemPtr cmdPBP, UInt16 launchFlags);
 
 /* FUNCTIONS */
 
-static void SearchRecordByScroll(UInt8 dir) {
-  DmOpenRef dbref;
-  LocalID dbid; 
-  MemHandle h;
-  UInt16 nrecs;
-  Char *pChar, *s, *d;
-
-  /* Open the DB and count the number of records. */
-  dbid = DmFindDatabase(0, dictionarydb);
-  if (dbid > 0) {
-    dbref = DmOpenDatabase(0, dbid, dmModeReadOnly);
-    if (dbref != NULL) {
-      nrecs = DmNumRecords(dbref);
-      /* Ensure we can read the record in lookuprec. */
-      if (lookuprec <= nrecs) {
-
-	if (dir > 0) {
-	  h = DmQueryRecord(dbref, lookuprec);
-	  if (h) {
-	    pChar = MemHandleLock(h);
-	    s = pChar;
-	    d = firstword;
-	    while ((*s != '\0') && (*s != '\t')) {
-	      s++;
-	      if (*s == '\t') {
-		while ((*s != '\0') && (*s != '\t')) {
-		  s++;
-		}
-	      }
-	    }
-	    /* should be at new word or end of file. */
-	    if (*s == '\t') {
-	      s++;
-	      /* read the new word. */
-	      while ((*s != '\0') && (*s != '\t')) {
-		*d++ = *s++;
-	      }
-	      *d = '\0';
-	      StrCopy(lookup, firstword);
-	    }
-	    else {
-	      /* definition is in the next record */
-	      /* - check the next record exists */
-	      /* - if so, read the first word and definition. */
-	    }
-
-	    
-	    /* Search for the next word following lookup. */
-	  
-	    MemHandleUnlock(h);
+/* Open the lexicon if it's there and hasn't been tried.  Returns
+   whether it's open. */
+static Boolean OpenLexicon(void) {
+  if (!lexicon.ref && !nolexicon && LexiconOpen(&lexicon, LEXICONDB) != errNone)
+    nolexicon = true;
 
-	  }
-	}
-      }
-      DmCloseDatabase(dbref);
-    }
-  }
+  return lexicon.ref != NULL;
 }
 
 
 
+/* The word in the Dict form, with its hooks after it if there's a
+   lexicon to find them in */
 static void DisplayLookupWord(Char *word) {
-  Char tmp[MAXDBTITLE + 1];
+  Char tmp[MAXDBTITLE + 2 + MAXNOHOOKS + 1 + MAXNOHOOKS + 1];
   Char *s, *d;
+  UInt32 front, back;
   
   s = word; d = tmp;
   while (*s) {
     *d++ = *s++;
   }
+
+  if (OpenLexicon() && d - tmp <= DAWGWORDMAX) {
+    DawgHooks(&lexicon.dawg, tmp, d - tmp, &front, &back);
+    if (front || back) {
+      *d++ = '\x19';
+      *d++ = '\x19';
+      d += CardHookString(front, d);
+      *d++ = '-';
+      d += CardHookString(back, d);
+    }
+  }
   *d = '\0';
-  SetField(pDictWordField, tmp, MAXDBTITLE + 1);
+  SetField(pDictWordField, tmp, sizeof(tmp));
 }
     
   
@@ -478,190 +560,278 @@ static void CleanUpString(Char *str) {
 
 
 
+/* Show text in the Dict form's text field, where it is.  The text has
+   to stay put until something else is shown. */
+static void ShowText(Char *text) {
+  FldSetTextPtr(pDictTextField, text);
+  FldRecalculateField(pDictTextField, true);
+}
+
+
+
+/* The dictionary is opened the first time it's wanted and then kept
+   open, with its index, until the application stops. */
+static Boolean OpenDictionary(void) {
+  if (!dict.ref && DictOpen(&dict, dictionarydb, LFD) != errNone) {
+    /* Cannot open DB */
+    FrmAlert(NoDictDatabase);
+    return false;
+  }
+
+  return true;
+}
+
+
+
 static void LookupDefinition(Char *word) {
-  /* Vars for the dictionary database. */
-  DmOpenRef dbref;
-  LocalID dbid; 
-  UInt16 nrecs, min = 0, max, mid, i, found = 0;
-  Int16 comp;
-  Char tmp[MAXDBTITLE+1];
-  Char *pChar, *r, *t;
-  /* safety-net in case the while loop fails to converge */
-  UInt16 iterations = 0, innextrecord;
+  const defCacheEntryType *e;
+  const Char *def;
+  Char key[MAXDBTITLE + 1];
 
   if (StrCompare(lookup, word) != 0) {
     StrCopy(lookup, word);
   }
-  
-  dbid = DmFindDatabase(0, dictionarydb);
-  if (dbid > 0) {
-    
-    dbref = DmOpenDatabase(0, dbid, dmModeReadOnly);
-    
-    if (dbref != NULL) {
-      nrecs = DmNumRecords(dbref);
-      max = nrecs - 1;
-      
-      /* Perform a binary search on the first entry of each record
-	 until we have the record in which the lookup word is contained.
-	 Variable "iterations" is used to prevent the search from running 
-	 away with itself.  Having refined the search method this should
-	 no longer be necessary but we'll leave it for now. */
-      
-      while ( (max - min) > 1) {
-	iterations++;
-	mid = (max + min) / 2;
-	
-	ReadFirstWordInRecord(dbref, mid);
-	
-	comp = StrCompare(lookup, firstword);
-	if (comp > 0)
-	  min = mid;
-	else
-	  max = mid;
-	
-	if (iterations == nrecs) break;
-      }
-      
-      /* Found the right record - now find the definition. */ 
-      
-      if (iterations < nrecs) {
-	/* lookup is in either min or max. */ 
-	ReadFirstWordInRecord(dbref, max);
-	if (StrCompare(lookup, firstword) < 0)
-	  max = min;
-      }
-      else {
-	/* the firstword binary search went wrong.  this needs an
-	   error message. */
-      }
-      
-      /* Lookup word should be in max record. */
-      ReadFirstWordInRecord(dbref, max);
-      /* Find the lookup word within the max record. */
-      innextrecord = SearchRecordForWord(dbref, max);
-      if (innextrecord == 1) {
-	if ((max+1) < nrecs) {
-	  SearchRecordForWord(dbref, max + 1);
-	}
-	else {
-	  /* give the notfound message */
-	  StrCopy(definition, "Not found.\0");
-	}
-      }
 
+  searching = false;
 
-      /* Lookup word and definition text should be saved in the global definition variable. */
-      DisplayLookupWord(lookup);
-      SetField(pDictTextField, definition, MAXDEFLENGTH+1);
-      
-      /* Close the dictionary database. */
-      DmCloseDatabase(dbref);
-    }
-  }
-  else {
-    /* Cannot open DB */
-    FrmAlert(NoDictDatabase);
+  /* A word looked up lately is shown as it was, without the dictionary */
+  e = DefCacheFind(&defcache, lookup);
+  if (e) {
+    lookuppos = e->pos;
+    lookupvalid = true;
+    StrCopy(lookup, e->word);
+
+    DisplayLookupWord(lookup);
+    ShowText((Char *) e->def);
+    return;
   }
+
+  if (!OpenDictionary())
+    return;
+
+  /* Find the lookup word.  If it isn't in the dictionary we display the
+     word that would follow it, and the lookup word becomes that word. */
+  StrCopy(key, lookup);
+  lookupvalid = DictFind(&dict, lookup, &lookuppos);
+  def = ShowDefinition();
+
+  if (def)
+    DefCacheAdd(&defcache, key, &lookuppos, lookup, def);
 }	
 
 
 
-static UInt16 SearchRecordForWord(DmOpenRef dbref, UInt16 id) {
-  MemHandle h;
-  Char *pChar, *s, *d;
-  Int16 comp;
-  UInt16 found = 0, innextrecord = 0;
-  Char tmp[32];
+/* Show the word at lookuppos, or the notfound message.  Returns the
+   definition shown, or NULL. */
+static const Char *ShowDefinition(void) {
+  dictViewType view;
+  UInt16 n;
 
-  h = DmQueryRecord(dbref, id);
-  if (h) {
-    pChar = MemHandleLock(h);
-    s = pChar;
+  if (!lookupvalid || !DictShow(&dict, &lookuppos, &view)) {
+    /* give the notfound message */
+    DisplayLookupWord(lookup);
+    ShowText(notfound);
+    return NULL;
+  }
 
-    while (found == 0) {
-      d = firstword;
-      lookuprec = id;
-      lookupoffset = s - pChar;
+  n = (view.wordlen < MAXDBTITLE) ? view.wordlen : MAXDBTITLE;
+  MemMove(lookup, view.word, n);
+  lookup[n] = '\0';
 
-      while ((*s != '\0') && (*s != '\t')) {
-	*d++ = *s++;
-      }
-      *d = '\0';
+  DisplayLookupWord(lookup);
+  ShowText((Char *) view.def);
+  return view.def;
+}
 
-      comp = StrCompare(lookup, firstword);
-      if (comp > 0) {            /* lookup word sorts after this one. */
-	s++;
-	while ((*s != '\0') && (*s != '\t')) {
-	  s++;       /* skim past the definition. */
-	}
-	if (*s == '\0') {
-	  found = 1;
-	  /* this means the lookup word was not in the dictionary and should
-	     have been the last word in the record.  So for consistency we should 
-	     display the first word in the next record. */
-	  innextrecord = 1;
-	}
-	else {
-	  s++;
-	}
-      }
-      else {
-	found = 1;
-	/* similar to the above paragraph - we have travelled past where the lookup
-	   word should sort and it was not found.  Thus we display the last found
-	   word which should be alphabetically after the lookup word. */
-
-	StrCopy(lookup, firstword);
-
-	// get the definition
-	d = definition;
-	s++;                // advance the source pointer
-	/* replace "\ and n" chars with real "\n" chars */
-	while ((*s != '\0') && (*s != '\t')) {
-	  if ((*s == 92) && (*(s+1) == 110)) {
-	    *d++ = '\n';
-	    s++; s++;
-	  }
-	  else {
-	    *d++ = *s++;
-	  }
-	}
-	*d = '\0';
-      }
+
+
+/* Show the next (dir > 0) or previous word in the dictionary.  At either
+   end the word shown stays.  While searching it's the next or previous
+   page of matches. */
+static void StepDefinition(Int8 dir) {
+  Boolean moved;
+
+  /* The word shown may have come from the cache */
+  if (!OpenDictionary())
+    return;
+
+  if (searching) {
+    if (dir > 0 && searchmore && searchpage < SEARCHPAGES - 1) {
+      searchpage++;
+      ShowSearchPage();
     }
+    if (dir < 0 && searchpage > 0) {
+      searchpage--;
+      ShowSearchPage();
+    }
+    return;
+  }
+
+  if (!lookupvalid)
+    return;
+
+  if (dir > 0)
+    moved = DictNext(&dict, &lookuppos);
+  else
+    moved = DictPrev(&dict, &lookuppos);
+
+  if (moved)
+    ShowDefinition();
+}
+
+
+
+/* Remember the entry shown, if there is one, before jumping away */
+static void PushHistory(void) {
+  if (searching || !lookupvalid)
+    return;
+
+  history[historytop] = lookuppos;
+  historytop = (historytop + 1) % HISTORYSIZE;
+  if (historycount < HISTORYSIZE)
+    historycount++;
+}
+
+
+
+/* Go back to the entry last jumped away from */
+static void BackDefinition(void) {
+  if (historycount == 0 || !OpenDictionary())
+    return;
+
+  historytop = (historytop + HISTORYSIZE - 1) % HISTORYSIZE;
+  historycount--;
+
+  searching = false;
+  lookuppos = history[historytop];
+  lookupvalid = true;
+  ShowDefinition();
+  SetField(pDictInputField, lookup, MAXDBTITLE+1);
+}
+
+
+
+/* Jump to the word selected in the definition.  A word the dictionary
+   has a cross-reference for is gone straight to; anything else is
+   looked up. */
+static void JumpToSelection(UInt16 hstart, UInt16 hend) {
+  Char tmp[MAXDBTITLE+1];
+  Char *textptr, *s, *t;
+  dictPosType target;
 
-    MemHandleUnlock(h);
+  if (!searching && lookupvalid && OpenDictionary() && DictLink(&dict, &lookuppos, hstart, &target)) {
+    PushHistory();
+    lookuppos = target;
+    ShowDefinition();
   }
   else {
-    /* Can't open the record.  Set the definition text to the lookup word
-       and popup an error form. */
+    textptr = FldGetTextPtr(pDictTextField);
+    s = tmp;
+    for (t = textptr + hstart; t < (textptr + hend); t++) {
+      *s++ = *t;
+    }
+    *s = '\0';
+    StrCopy(lookup, tmp);
+    CleanUpString(lookup);
+
+    PushHistory();
+    LookupDefinition(lookup);
   }
 
-  return innextrecord;
+  /* As we are jumping to the word it needs to be written into the input field. */
+  SetField(pDictInputField, lookup, MAXDBTITLE+1);
 }
 
 
-static void ReadFirstWordInRecord(DmOpenRef dbref, UInt16 id) 
-{
-  MemHandle h;
-  Char *pChar, *s, *d;
-  
-  h = DmQueryRecord(dbref, id);
-  if (h) {
-    pChar = MemHandleLock(h);
-    s = pChar;
-    d = firstword;
-    while ((*s != '\0') && (*s != '\t')) {
-      *d++ = *s++;
+
+/* Find all of the current card's answers in the dictionary in one go.
+   A missing dictionary isn't worth an alert here - it will get one if
+   a word is looked up. */
+static void PrefetchDefinitions(void) {
+  Char (*words)[MAXWORDLENGTH + 1] = answerwords;
+  UInt16 i, j;
+
+  for (i = 0; i < flash->count; i++)
+    answerfound[i] = false;
+
+  if (!prefs.prefetchdefs || flash->count == 0 || nodictionary)
+    return;
+
+  if (!dict.ref && DictOpen(&dict, dictionarydb, LFD) != errNone) {
+    nodictionary = true;
+    return;
+  }
+
+  /* Lowercased and cut at the first non-letter, as the list does */
+  for (i = 0; i < flash->count; i++) {
+    for (j = 0; j < MAXWORDLENGTH; j++) {
+      if (flash->words[i][j] >= 'A' && flash->words[i][j] <= 'Z')
+	words[i][j] = flash->words[i][j] + 32;
+      else if (flash->words[i][j] >= 'a' && flash->words[i][j] <= 'z')
+	words[i][j] = flash->words[i][j];
+      else
+	break;
+    }
+    words[i][j] = '\0';
+    answerptrs[i] = words[i];
+  }
+
+  DictFindAll(&dict, answerptrs, flash->count, answerpos, answerfound);
+}
+
+
+
+/* Start the search parsed into query from its first page */
+static void SearchDictionary(void) {
+  if (!OpenDictionary())
+    return;
+
+  searching = true;
+  searchpage = 0;
+  searchpages[0].rec = 0;
+  searchpages[0].entry = 0;
+  ShowSearchPage();
+}
+
+
+
+/* Show as many matches as fit from the start of the current page, and
+   note where the next page starts.  Building the page is the search -
+   the signatures (see dict.h) keep it quick. */
+static void ShowSearchPage(void) {
+  dictPosType pos = searchpages[searchpage];
+  const Char *word;
+  Char *d, *end = pagetext + SEARCHPAGESIZE - 4;   /* Room for " ..." */
+  UInt16 n = 0, len;
+
+  StrPrintF(pagetext, "Page %u:\n", searchpage + 1);
+  d = pagetext + StrLen(pagetext);
+
+  /* Only the words are listed so no definition need be unpacked */
+  searchmore = false;
+  while (DictSearch(&dict, &query, &pos) && DictWord(&dict, &pos, &word, &len)) {
+    if (d + len + 1 > end) {
+      searchmore = true;
+      break;
     }
-    *d = '\0';
-    MemHandleUnlock(h);
+
+    if (n++ > 0)
+      *d++ = ' ';
+    MemMove(d, word, len);
+    d += len;
+    pos.entry++;
   }
- else {
-    StrCopy(firstword, "\0");
- }
+  *d = '\0';
+
+  if (n == 0)
+    StrCopy(pagetext, "No words match.");
+  else if (searchmore && searchpage == SEARCHPAGES - 1)
+    StrCat(pagetext, " ...");
 
+  searchpages[searchpage + 1] = pos;
+
+  DisplayLookupWord(query.text);
+  ShowText(pagetext);
 }
 
 
@@ -692,10 +862,10 @@ static void flashcardShowAll(void)
 {
   if (state.visible > 0)
     {
-      if (revealed < flash.count)
+      if (revealed < flash->count)
 	{
 	  clues = 0;
-	  revealed = flash.count;
+	  revealed = flash->count;
 	  ShowAnswers(revealed, clues);
 	}
     }
@@ -705,7 +875,7 @@ static void flashcardShowOne(void)
 {
   if (state.visible > 0)
     {
-      if (revealed < flash.count)
+      if (revealed < flash->count)
 	{
 	  clues = 0;
 	  revealed++;
@@ -716,11 +886,11 @@ static void flashcardShowOne(void)
 
 static void flashcardShowClue(void)
 {
-  if (revealed < flash.count)
+  if (revealed < flash->count)
     {
       if (!doingHooks) 
 	{
-	  if (clues < StrLen(flash.words[0]))
+	  if (clues < StrLen(flash->words[0]))
 	    clues++;
 	}
       ShowAnswers(revealed, clues);
@@ -738,12 +908,12 @@ static void flashcardDelete(void)
 {
   if (state.visible > 1)
     {
-      if (revealed == flash.count)
+      if (revealed == flash->count)
 	DeleteAndDoNext();
     }
   else if (state.visible == 1)
     {
-      if (revealed == flash.count)
+      if (revealed == flash->count)
 	DeleteAndStop();
     }
 }
@@ -776,22 +946,17 @@ static void CleanUpDBPointers(void)
 
 static void SaveOrderData(void)
 {
-
   UInt16           index;
-  UInt16         records;
-  UInt16               i;
+  UInt32        cardlen;
+  UInt32       shownlen;
   
-  MemHandle h;
-  dbOrderType        old;
-  dbOrderType      *oldp;
-  dbOrderType        new;
-  dbOrderType      *newp;
+  MemHandle            h;
+  dbOrderType        hdr;
+  void             *recp;
   
   LocalID           dbID;
   DmOpenRef        dbRef;
   
-  oldp = &old;  /* Necessary?  It gets reset below... */
-  
   /* Find the data DB */
   dbID = DmFindDatabase(0, LFD);
   if (dbID)
@@ -800,46 +965,35 @@ static void SaveOrderData(void)
       dbRef = DmOpenDatabase(0, dbID, dmModeReadWrite);
       if (dbRef)
 	{
-	  /* Read the number of records in the DB */
-	  records = DmNumRecords(dbRef);
-	  /* Read the existing data... 
-	   * until we find one matching the current set, then delete it
-	   */
-	  if (records > 0)
-	    {
-	      for (i = 0; i < records; i++)
-		{
-		  h = DmQueryRecord(dbRef, i);
-		  if (h)
-		    {
-		      oldp = (dbOrderType *) MemHandleLock(h);
-		      MemHandleUnlock(h);
-		      
-		      if (StrCompare(oldp->title, state.dbname) == 0)
-			{
-			  /* Found the old data.  Delete it */
-			  DmDeleteRecord(dbRef, i);
-			  break;
-			}
-		    }
-		}
-	    }
+	  /* Delete the existing data for the current set */
+	  RemoveOrderData(dbRef, state.dbname);
 	  
-	  /* Copy current data into new */
-	  StrCopy(new.title, state.dbname);
-	  new.total = state.total;
-	  for (i = 0; i < state.total; i++)
-	    new.order[i] = state.order[i];
+	  StrCopy(hdr.title, state.dbname);
+	  hdr.magic = ORDERMAGIC;
+	  hdr.total = quiz.total;
+	  hdr.size = quiz.size;
+	  hdr.seed = quiz.seed;
+	  hdr.cursor = quiz.cursor;
 	  
-	  /* Find the last record index */
-	  index = dmMaxRecordIndex;	    
+	  cardlen = QuizWordCount(quiz.total) * sizeof(UInt32);
+	  shownlen = QuizWordCount(quiz.size) * sizeof(UInt32);
 	  
-	  /* Create a new record and write data */
-	  h = DmNewRecord(dbRef, &index , sizeof(dbOrderType));
-	  newp = MemHandleLock(h);
-	  DmWrite(newp, 0, &new, sizeof(dbOrderType));
-	  MemHandleUnlock(h);
-	  DmReleaseRecord(dbRef, index, true);
+	  /* Create a new record at the end and write data */
+	  index = dmMaxRecordIndex;	    
+	  h = DmNewRecord(dbRef, &index, sizeof(dbOrderType) + cardlen + shownlen);
+	  if (h)
+	    {
+	      recp = MemHandleLock(h);
+	      DmWrite(recp, 0, &hdr, sizeof(dbOrderType));
+	      DmWrite(recp, sizeof(dbOrderType), QuizCardBits(&quiz), cardlen);
+	      DmWrite(recp, sizeof(dbOrderType) + cardlen, QuizShownBits(&quiz), shownlen);
+	      MemHandleUnlock(h);
+	      DmReleaseRecord(dbRef, index, true);
+	    }
+	  else
+	    {
+	      FrmAlert(DBOrderSaveFailed);
+	    }
 	  
 	  DmCloseDatabase(dbRef);
 	}
@@ -858,40 +1012,140 @@ static void SaveOrderData(void)
 }
 
 
+
+/* Read the saved deal of state.dbname back into quiz, which must already
+   be set up for the DB.  Returns true if the deal was recovered. */
+static Boolean LoadOrderData(void)
+{
+  UInt16         records;
+  UInt16               i;
+  UInt32               j;
+  UInt32         cardlen;
+  UInt32        shownlen;
+  UInt32           *bits;
+  Boolean      recovered = false;
+  
+  MemHandle            h;
+  dbOrderType         *p;
+  dbLegacyOrderType  *lp;
+  
+  LocalID           dbID;
+  DmOpenRef        dbRef;
+  
+  if (quiz.total == 0)
+    return false;
+  
+  dbID = DmFindDatabase(0, LFD);
+  if (!dbID)
+    return false;
+  
+  dbRef = DmOpenDatabase(0, dbID, dmModeReadOnly);
+  if (!dbRef)
+    return false;
+  
+  records = DmNumRecords(dbRef);
+  for (i = 0; i < records && !recovered; i++)
+    {
+      h = DmQueryRecord(dbRef, i);
+      if (h == NULL || MemHandleSize(h) < sizeof(dbOrderType))
+	continue;
+      
+      p = (dbOrderType *) MemHandleLock(h);
+      if (StrCompare(p->title, state.dbname) == 0)
+	{
+	  if (p->magic == ORDERMAGIC && p->total == quiz.total && p->size <= p->total)
+	    {
+	      /* Read back the bits and replay the deal - ignore it if the
+		 DB has changed size */
+	      cardlen = QuizWordCount(p->total) * sizeof(UInt32);
+	      shownlen = QuizWordCount(p->size) * sizeof(UInt32);
+	      if (MemHandleSize(h) == sizeof(dbOrderType) + cardlen + shownlen)
+		{
+		  MemMove(QuizCardBits(&quiz), p + 1, cardlen);
+		  MemMove(QuizShownBits(&quiz), (UInt8 *) (p + 1) + cardlen, shownlen);
+		  recovered = (QuizRestore(&quiz, p->seed, p->size, p->cursor) == errNone);
+		}
+	    }
+	  else if (MemHandleSize(h) == sizeof(dbLegacyOrderType))
+	    {
+	      /* Convert an old style record.  Its order can't be kept but
+		 the cards that were deleted stay deleted. */
+	      lp = (dbLegacyOrderType *) p;
+	      if (lp->total == quiz.total)
+		{
+		  bits = QuizCardBits(&quiz);
+		  MemSet(bits, QuizWordCount(lp->total) * sizeof(UInt32), 0);
+		  for (j = 0; j < lp->total; j++)
+		    if (lp->order[j] > 0)
+		      bits[(lp->order[j] - 1) >> 5] |= 1UL << ((lp->order[j] - 1) & 31);
+		  
+		  MemSet(QuizShownBits(&quiz), QuizWordCount(lp->visible) * sizeof(UInt32), 0xff);
+		  recovered = (QuizRestore(&quiz, NextSeed(), lp->visible, 0) == errNone);
+		}
+	    }
+	}
+      MemHandleUnlock(h);
+    }
+  
+  DmCloseDatabase(dbRef);
+  
+  return recovered;
+}
+
+
+
+/* Remove every lampflash.data record belonging to the named DB */
+static void RemoveOrderData(DmOpenRef dbRef, Char *title)
+{
+  UInt16               i = 0;
+  MemHandle            h;
+  dbOrderType         *p;
+  Boolean          match;
+  
+  while (i < DmNumRecords(dbRef))
+    {
+      match = false;
+      h = DmQueryRecord(dbRef, i);
+      if (h)
+	{
+	  p = (dbOrderType *) MemHandleLock(h);
+	  match = (StrCompare(p->title, title) == 0);
+	  MemHandleUnlock(h);
+	}
+      
+      /* Removing the record shuffles the rest down so don't advance */
+      if (match)
+	DmRemoveRecord(dbRef, i);
+      else
+	i++;
+    }
+}
+
+
 static void UndeleteAll(void)
 {
   /* This is duplication of effort but this thing has got become
      so spaghetti-fied I can't bare to try to unravel the thing. */
-  UInt16 i;
   
-  state.visible = state.total;
+  /* Put every card back in the quiz.  Cards deleted before the last
+     shuffle aren't in the current deal so this means dealing afresh. */
+  state.visible = QuizUnhideAll(&quiz, NextSeed());
   state.seen = 0;
   
-  /* This counter is 1 - N+1 while the array reference is 
+  /* This counter is 1 - N+1 while the order position is 
      obviously 0 - N.  This has tripped me up once! */
   state.curr = state.seen + 1;  
   state.dbcurrec = state.seen;
   restore = false; 
   
-  /* Cycle through order[] and make all values positive (all positive
-     referenced numbers are shown - negative values are hidden */
-  
-  for (i = 0; i < state.total; i++)
-    {
-      if (state.order[i] < 0)
-	{
-	  state.order[i] = Abs(state.order[i]);
-	}
-    }
-  
   /* Get the new flashcard and display it */
   
   GetNewFlashcard();
   OrderNewFlashcard();
   SetWordOrder();
   SetFlashNumber(state.curr);
-  SetCounter(flash.count);
-  SetUpFlashcardField();
+  SetCounter(flash->count);
+  RackInvalidate(&rack);
   SetFlashField();  
 }
 
@@ -932,7 +1186,7 @@ static void DeleteAndStop()
      the counters and displays are blanked. */
   
   state.visible = 0;
-  state.order[state.seen] = (-1) * state.order[state.seen];
+  QuizHide(&quiz, state.seen);
   state.curr = 0;
   DrawBlankForm();
 }
@@ -942,29 +1196,14 @@ static void DoShuffle()
 {
   /* We must ONLY call DoShuffle if we have more than one unseen */
   
-  UInt16 i = 0, r, t;
+  /* Shuffle the order - a new deal of the cards still visible */
+  QuizDeal(&quiz, NextSeed());
+  state.visible = QuizCountVisible(&quiz);
   
-  /* Shuffle the order */
-  for (; i < state.total; i++)
-    {
-      r = RandomNum(state.total);
-      t = state.order[i];
-      state.order[i] = state.order[r];
-      state.order[r] = t;
-    }
-  
-  /* Reset the order counter */
-  state.seen = 0; 
-  
-  /* Find the first undeleted (positive) entry */
-  while (state.order[state.seen] < 0)
-    {
-      if (state.seen < state.total - 1)
-	state.seen++;
-    }		    
+  /* Reset the order counter to the first undeleted entry */
+  state.seen = QuizSelect(&quiz, 0);
   
   /* Update the current counter */
-  state.dbcurrec = state.seen + 1;
   state.curr = 1;
   
   
@@ -974,7 +1213,7 @@ static void DoShuffle()
   OrderNewFlashcard();
   SetFlashNumber(state.curr);
   SetFlashField(flashcard);
-  SetCounter(flash.count);
+  SetCounter(flash->count);
   
 }
 
@@ -983,34 +1222,28 @@ static void DoShuffle()
 
 static void DeleteAndDoNext()
 {
-  /* Delete the question by making its order reference negative */
+  /* Delete the question by clearing its visibility bit */
   
-  /* Check that it isn't already negative.  This probably isn't 
+  /* Check that it isn't already hidden.  This probably isn't 
      necessary but we do it anyway. */
-  if (state.order[state.seen] > 0)
+  if (!QuizIsHidden(&quiz, state.seen))
     {
-      /* Negate order reference */
-      state.order[state.seen] = (-1) * state.order[state.seen];
+      QuizHide(&quiz, state.seen);
       
-      if (state.visible == state.curr)
+      /* Always update the visible counter */
+      state.visible = QuizCountVisible(&quiz);
+      
+      if (state.curr > state.visible)
 	{
-	  /* Reduce the counter of visible flashcards */
-	  state.curr--;
-	  
-	  /* Find the last (previous) undeleted flashcard */ 
-	  while(state.order[state.seen] < 0)
-	    state.seen--;
+	  /* This was the last flashcard so find the previous one */ 
+	  state.seen = QuizPrevVisible(&quiz, state.seen);
 	}
       else
 	{
 	  /* Find the next undeleted flashcard */
-	  while(state.order[state.seen] < 0)
-	    state.seen++;
-	  
+	  state.seen = QuizNextVisible(&quiz, state.seen);
 	}
-      
-      /* Always update the visible counter */
-      state.visible--;
+      state.curr = QuizRank(&quiz, state.seen) + 1;
       
       /* Get a new flashcard and Update the displays */
       ShowAnswers(NONE, 0);
@@ -1018,7 +1251,7 @@ static void DeleteAndDoNext()
       OrderNewFlashcard();
       SetFlashField(flashcard);
       SetFlashNumber(state.curr);
-      SetCounter(flash.count);
+      SetCounter(flash->count);
     }
 }
 
@@ -1085,9 +1318,6 @@ static void DeleteDB(Char *db)
 {
   LocalID              dbID;
   DmOpenRef           dbRef;
-  UInt16               n, i;
-  MemHandle               h;
-  dbOrderType            *p;
   
   /* Delete flashcard database */ 
   
@@ -1107,26 +1337,7 @@ static void DeleteDB(Char *db)
       dbRef = DmOpenDatabase(0, dbID, dmModeReadWrite);
       if (dbRef)
 	{
-	  n = DmNumRecords(dbRef);
-	  if (n > 0)
-	    {
-	      for (i = 0; i < n; i++)
-		{
-		  h = DmQueryRecord(dbRef, i);
-		  if (h)
-		    {
-		      p = (dbOrderType *) MemHandleLock(h);
-		      MemHandleUnlock(h);
-		      
-		      if (StrCompare(p->title, db) == 0)
-			{
-			  DmDeleteRecord(dbRef, i);
-			  break;
-			}
-		      //DmReleaseRecord(dbRef, i, false);
-		    }
-		}
-	    }
+	  RemoveOrderData(dbRef, db);
 	  DmCloseDatabase(dbRef);
 	}
     }
@@ -1238,98 +1449,190 @@ static void SetWordOrder()
 
 
 
-/* Display the flashcard solutions */
+/* Format answer d into line, which has room for MAXLINELENGTH - the
+   answer, a small space and then the hooks (if prefs is set).  The
+   hooks are only written out as letters here.  A deck made without
+   hooks has them found in the lexicon instead, if there is one. */
+static void FormatAnswer(UInt16 d, Char *line)
+{
+  Char *s;
+  UInt32 front = flash->front[d], back = flash->back[d];
+
+  StrCopy(line, flash->words[d]);
+
+  /* The letter a blank stands for is shown in lowercase - the last of
+     them, as the blank is played after the tiles of its letter */
+  if (flash->blank[d])
+    {
+      s = StrChr(line, flash->blank[d]);
+      while (s && StrChr(s + 1, flash->blank[d]))
+	s = StrChr(s + 1, flash->blank[d]);
+      if (s)
+	*s += 32;
+    }
+
+  StrCat(line, "\x19\x19");     
+
+  if (prefs.showhooks && !front && !back && OpenLexicon())
+    DawgHooks(&lexicon.dawg, flash->words[d], StrLen(flash->words[d]), &front, &back);
+  
+  if (prefs.showhooks && (front || back)) 
+    {
+      s = line + StrLen(line);
+      s += CardHookString(front, s);
+      *s++ = '-';
+      CardHookString(back, s);
+    }
+}
+
+
+
+/* List draw function for the answers.  Installed so that a single row
+   can be drawn by us exactly as LstDrawList() would draw it.  An
+   answer is formatted here, as its row is drawn, so only the rows on
+   show ever are - a card can have thousands of answers. */
+static void DrawAnswerRow(Int16 item, RectangleType *bounds, Char **text)
+{
+  static Char line[MAXLINELENGTH + 1];
+  Char *s = text[item];
+
+  if (s != cluetxt)
+    {
+      FormatAnswer(item, line);
+      s = line;
+    }
+
+  WinDrawTruncChars(s, StrLen(s), bounds->topLeft.x + 2,
+		    bounds->topLeft.y, bounds->extent.x - 2);
+}
+
+
+
+/* Draw just row item of the answers list, which has top at the top */
+static void DrawAnswerListRow(UInt16 item, UInt16 top)
+{
+  RectangleType r;
+  FontID font = FntSetFont(stdFont);
+  Int16 h = FntLineHeight();
+
+  FrmGetObjectBounds(pCurForm, FrmGetObjectIndex(pCurForm, MainWordList), &r);
+  r.topLeft.y += (item - top) * h;
+  r.extent.y = h;
+
+  WinEraseRectangle(&r, 0);
+  DrawAnswerRow(item, &r, pMainWordListPtrArray);
+  FntSetFont(font);
+}
+
+
+
+/* Scroll the answers list up a row and draw the row uncovered at the
+   bottom, which is item with the list now starting at top */
+static void ScrollAnswerList(UInt16 item, UInt16 top)
+{
+  RectangleType r, vacated;
+  FontID font = FntSetFont(stdFont);
+  Int16 h = FntLineHeight();
+
+  FrmGetObjectBounds(pCurForm, FrmGetObjectIndex(pCurForm, MainWordList), &r);
+  r.extent.y = LISTSIZE * h;
+  WinScrollRectangle(&r, winUp, h, &vacated);
+  WinEraseRectangle(&vacated, 0);
+
+  FntSetFont(font);
+  DrawAnswerListRow(item, top);
+}
+
+
+
+/* Display the flashcard solutions - the first max answers and clues
+   letters of the next one.
+
+   Answer lines are formatted by DrawAnswerRow() as they're drawn, so
+   revealing another answer formats only the rows on show.  When just one row
+   has changed since the last call, and it's the last row, only that
+   row is drawn (scrolling the list up a row to make room if need be).
+   Anything else redraws the whole list. */
 static void ShowAnswers(UInt16 max, UInt16 clues)
 {
   UInt16 d, j;
-  UInt16 drawmax;
-  Char *p, *s;
-  Char tmp[10] = "";
-  
-  /* We first set up an array of pointers to the list of answers 
-     displayed on the main form */ 
-  
-  /* But we piggy-back the loop to format the actual text to be 
-     displayed - the answers, spacing and hooks etc. */
-  
-  for (d = 0; d < max; d++)
+  UInt16 drawmax, top;
+  UInt16 oldmax = listmax + (listclues > 0);
+  UInt16 oldtop = oldmax <= LISTSIZE ? 0 : oldmax - LISTSIZE;
+  const Char *p;
+  Char *s;
+  
+  /* Changing whether hooks are shown changes every row */
+  if (formattedhooks != prefs.showhooks)
     {
-      /* Copy the answers */
-      StrCopy(display[d], flash.words[d]);
-      
-      /* Add a small space before displaying the hooks */
-      StrCat(display[d], "\x19\x19");     
-      
-      /* Add the hooks (if prefs is set) */
-      if (prefs.showhooks) 
-	{
-	  StrCat(display[d], flash.front[d]);
-	  if (StrLen(flash.front[d]) > 0 || StrLen(flash.back[d]) > 0)
-	    {
-	      StrCat(display[d], "-");
-	    }
-	  StrCat(display[d], flash.back[d]);
-	}
-      
-      /* And actually set up the pointers */
-      pMainWordListPtrArray[d] = display[d];
+      formattedhooks = prefs.showhooks;
+      listvalid = false;
     }
+
+  /* Point the list at the answers */
+  for (d = 0; d < max; d++)
+    pMainWordListPtrArray[d] = (Char *) flash->words[d];
   
   /* Declare the number of lines in the list */ 
   drawmax = max;
   
-  if (clues > 0 && max < flash.count)
+  /* The clue row has a buffer of its own, which is how it's told from
+     an answer's row */
+  if (clues > 0 && max < flash->count)
     {
-      p = flash.words[max];
-      s = tmp;
-      for (j = 0; j < clues; j++)
+      p = flash->words[max];
+      s = cluetxt;
+      for (j = 0; j < clues && *p; j++)
 	*s++ = *p++;
       *s = '\0';
       
-      StrCopy(display[drawmax], tmp);
-      pMainWordListPtrArray[drawmax] = display[drawmax];
+      pMainWordListPtrArray[drawmax] = cluetxt;
       /* Update the number of clues displayed so far*/
       drawmax++;                 
     }
   
+  top = drawmax <= LISTSIZE ? 0 : drawmax - LISTSIZE;
+
   /* Finally, show the words and set the list scrollbar */
   
   LstSetListChoices(pMainWordList, pMainWordListPtrArray, drawmax);
-  LstSetTopItem(pMainWordList, drawmax <= LISTSIZE ? 0 : drawmax - LISTSIZE);
+  LstSetTopItem(pMainWordList, top);
   LstSetSelection(pMainWordList, noListSelection);
-  LstDrawList(pMainWordList);
-  SclSetScrollBar(pMainScrollBar, drawmax <= LISTSIZE ? 0 : drawmax - LISTSIZE, 0,
-		  drawmax <= LISTSIZE ? 0 : drawmax - LISTSIZE, LISTSIZE);
-    
-}
-
 
-/* Handle looping around the end of the flashcard set and 
-   also hidding the flashcards that are deleted. */
-static void DoNext()
-{
-  state.seen = (state.seen + 1) % (state.total);
-  while (state.order[state.seen] < 0)
+  if (listvalid && max == listmax && drawmax == oldmax
+      && (drawmax == max || clues == listclues))
     {
-      state.seen = (state.seen + 1) % (state.total);
-    }		    
-  
-  if (state.order[state.seen] > 0)
+      /* Nothing has changed */
+    }
+  else if (listvalid && drawmax > 0 && max >= listmax
+	   && (drawmax == oldmax || drawmax == oldmax + 1)
+	   && (max == listmax ? clues != listclues : max == listmax + 1))
     {
-      if (state.curr < state.visible)
-	{
-	  state.curr++;
-	}
+      /* Only the last row is new or different.  If there's one more
+	 row than before the list may have to move up to show it. */
+      if (top != oldtop)
+	ScrollAnswerList(drawmax - 1, top);
       else
-	{
-	  state.curr = 1;
-	}
+	DrawAnswerListRow(drawmax - 1, top);
     }
   else
-    {
-      /* Add some code here to handle the unlikely event */
-      ;
-    }
+    LstDrawList(pMainWordList);
+
+  SclSetScrollBar(pMainScrollBar, top, 0, top, LISTSIZE);
+
+  listmax = max;
+  listclues = (max < flash->count) ? clues : 0;
+  listvalid = true;
+}
+
+
+/* Handle looping around the end of the flashcard set and 
+   also hidding the flashcards that are deleted.  The card number
+   shown is the rank of the card among those still visible. */
+static void DoNext()
+{
+  state.seen = QuizNextVisible(&quiz, state.seen);
+  state.curr = QuizRank(&quiz, state.seen) + 1;
   
   /* Get a new flashcard and update the display and counters */
   ShowAnswers(NONE, 0);
@@ -1337,7 +1640,7 @@ static void DoNext()
   OrderNewFlashcard();
   SetFlashNumber(state.curr);
   SetFlashField(flashcard);
-  SetCounter(flash.count);
+  SetCounter(flash->count);
 }
 
 
@@ -1345,29 +1648,8 @@ static void DoNext()
 /* Similar to DoNext() above */
 static void DoLast()
 {
-  if (state.seen <= 0) state.seen = state.total - 1;
-  else state.seen--;
-  
-  while (state.order[state.seen] < 0)
-    {
-      if (state.seen <= 0) 
-	{
-	  state.seen = state.total - 1;
-	}
-      else
-	{
-	  state.seen--;
-	}
-    }		    
-  
-  if (state.curr > 1)
-    {
-      state.curr--;
-    }
-  else
-    {
-      state.curr = state.visible;
-    }
+  state.seen = QuizPrevVisible(&quiz, state.seen);
+  state.curr = QuizRank(&quiz, state.seen) + 1;
   
   /* Get the next flashcard and update the display */
   GetNewFlashcard();
@@ -1375,101 +1657,26 @@ static void DoLast()
   SetFlashNumber(state.curr);
   ShowAnswers(NONE, 0);
   SetFlashField(flashcard);
-  SetCounter(flash.count);
+  SetCounter(flash->count);
 }
 
 
 static void ClearFlashField()
 {
-  RectangleType r;
-  
-  /* Clear a big rectangle of full screen width by tile height.  Not
-     pretty but it works. */ 
-  
-  r.topLeft.x = 0;
-  r.topLeft.y = YOFFSET;
-  r.extent.x = 159;
-  r.extent.y = TILEHEIGHT;
-  WinEraseRectangle(&r, 0);
-  
-}
-
-static void DrawTile(RectangleType rec, Char c, UInt8 border)
-{
-  RectangleType rp = rec;
-  FontID  oldfont;
-  
-  /* Draw a black rectangle */
-  WinDrawRectangle(&rp, 3);
-  
-  /* Resize the rectangle by one pixel on each side 
-     and move the rectangle so it is centred in the middle
-     of the one drawn above. */
-  rp.topLeft.x ++;
-  rp.topLeft.y ++;
-  rp.extent.x -= 2;
-  rp.extent.y -= 2;
-  
-  /* Remove the inner rectangle - or draw a while rectangle */
-  if (!border)
-    WinEraseRectangle(&rp, 3);
-  
-  /* The fonts don't display the way we'd like so they 
-     may need shifting a little.  Offending letters are those
-     of the new Collins word WAI (meaning water). */
-  if (c == 'I') rp.topLeft.x++;                
-  if (c == 'A' || c == 'W') rp.topLeft.x--;    
-  
-  /* Save the current font and reset the font to largeBold */ 
-  oldfont = FntSetFont(largeBoldFont);
-  
-  /* Draw the letter in the rectangle */
-  if (border)
-    WinDrawInvertedChars(&c, 1, rp.topLeft.x + 3, rp.topLeft.y);
-  else
-    WinDrawChar(c, rp.topLeft.x + 3, rp.topLeft.y);
-  
-  /* Reset the current font to whatever it was. */ 
-  FntSetFont(oldfont);
-  
-}
-
-
-static void SetUpFlashcardField() 
-{
-  UInt8 xoffset, i, cardlen;
-  
-  /* xoffset is the midpoint minus half the width of the rack and
-     we assume the X midpoint is at 79 (or so). */
-  
-  cardlen = StrLen(flashcard);
-  xoffset = 79 - cardlen * (TILEWIDTH + TILESPACE) / 2;
-  
-  for (i = 0; i < cardlen ; i++)
-    {
-      rack[i].topLeft.x = xoffset + i * (TILEWIDTH + TILESPACE);
-      rack[i].topLeft.y = YOFFSET;
-      rack[i].extent.x = TILEWIDTH;
-      rack[i].extent.y = TILEHEIGHT;
-    }
+  RackErase(&rack);
 }
 
 
 
-
 /* Update the flashcard display */
 static void SetFlashField()
 {
-  /* Get the length of the flashcard */
-  UInt16 cardlen = StrLen(flashcard);
-  UInt8 i;
   FontID oldfont;
 
   if (prefs.showtiles != 0)
     {
-      /* Draw the rack tiles individually */
-      for (i = 0; i < cardlen; i++)
-	DrawTile(rack[i], flashcard[i], 0);
+      /* Draw the rack tiles that have changed */
+      RackDraw(&rack, flashcard, highlight);
     }
   else
     {
@@ -1505,19 +1712,8 @@ static void OrderNewFlashcard()
 /* Randomise the tiles of the flashcard */
 static void RandomiseFlashcard()
 {
-  UInt8 i, r, len = StrLen(flashcard);
-  Char tmp;  /* Single character buffer */
-  
   if (!doingHooks)
-    {
-      for (i = 0; i < len; i++)
-	{
-	  tmp = flashcard[i];
-	  r = RandomNum(len);
-	  flashcard[i] = flashcard[r];
-	  flashcard[r] = tmp;
-	}
-    }
+    RndShuffleChars(&state.rng, flashcard, StrLen(flashcard));
 }
 
 
@@ -1577,128 +1773,57 @@ static void AlphagramiseFlashcard()
 
 
 
-/* Reset the quiz stats values */
-static void ResetStats()
+/* Start the quiz afresh - for when LFD has no deal saved for it */
+static void DefaultStats()
 {
-  UInt16       i, t, r;
-  LocalID        dbID;
-  UInt16      records;
+  /* Defaults here are set when we cannot find data DB */
+  state.total = dbnumrec;
+  state.visible = state.total;
+  
+  state.seen = 0;
+  state.curr = state.seen + 1;
   
-  dbOrderType *  oldp;
-  DmOpenRef     dbRef;
-  MemHandle         h;
+  state.dbcurrec = 0;
   
-  Boolean    recovered = false;
+  /* A new quiz gets a new seed */
+  state.seed = NewSeed();
+  RndSeed(&state.rng, state.seed);
   
+  /* Deal every card in a random order.  Nothing is shuffled
+     until the quiz gets to it so this is quick for any size of deck. */
+  QuizUnhideAll(&quiz, NextSeed());
+}
 
+/* Reset the quiz stats values */
+static void ResetStats()
+{
   /* Does the state.dbname have an entry in LFD */
-  dbID = DmFindDatabase(0, LFD);
-  if (dbID)
-    {
-      /* Open the data DB */
-      dbRef = DmOpenDatabase(0, dbID, dmModeReadOnly);
-      if (dbRef)
-	{
-	  /* Read the number of records in the DB */
-	  records = DmNumRecords(dbRef);
-	  if (records > 0)
-	    {
-	      for (i = 0; i < records; i++)
-		{
-		  h = DmQueryRecord(dbRef, i);
-		  if (h)
-		    {
-		      oldp = (dbOrderType *) MemHandleLock(h);
-		      MemHandleUnlock(h);
-		      if (StrCompare(oldp->title, state.dbname) == 0)
-			{
-			  StrCopy(state.dbname, oldp->title);
-			  state.total = oldp->total;
-			  for (i = 0; i < state.total; i++)
-			    state.order[i] = oldp->order[i];
-			  recovered = true;
-			  break;
-			}
-		    }
-		}
-	    }
-	  DmCloseDatabase(dbRef);
-	}		
-    }
-  
-  if (recovered)
+  if (LoadOrderData())
     {
       /* Set up peripheral data and the order */
-      /* state.total == dbnumrec; */
-      state.visible = 0;
-      for (i = 0; i < state.total; i++)
-	if (state.order[i] > 0)
-	  state.visible++;
+      state.total = quiz.total;
+      state.visible = QuizCountVisible(&quiz);
       
-      state.seen = 0;
-      state.curr = state.seen + 1;
-      if (state.visible > 0)
-	while(state.order[state.seen] < 0)
-	  state.seen++;
+      state.seen = (state.visible > 0) ? QuizSelect(&quiz, 0) : 0;
+      state.curr = 1;
       state.dbcurrec = state.seen;
     }
   else
-    {
-      /* Defaults here are set when we cannot find data DB */
-      state.total = dbnumrec;
-      state.visible = state.total;
-      
-      state.seen = 0;
-      state.curr = state.seen + 1;
-      
-      state.dbcurrec = 0;
-      
-      /* Set up sequential order */
-      for (i = 0; i < state.total; i++)
-	state.order[i] = i + 1;               /* 1 - max */
-      
-      /* Randomise the selection */
-      
-      /* is this the right thing to do here? 
-	 don't suppose it does any harm */
-      for (i = 0; i < state.total; i++) 
-	{
-	  r = RandomNum(state.total);
-	  t = state.order[i];
-	  state.order[i] = state.order[r];
-	  state.order[r] = t;
-	}
-      
-    }
+    DefaultStats();
 }
 
 static void ReorderFlashcards()
 {
-  UInt16 i;
-  Int16 tmp[MAXNOFLASHCARDS];
-  Int16 t, r;
-  
   /* 
    * Order the flashcards sequentially or randomly 
    */
   
   /* Set up Random order */
-  for (i = 0; i < state.total; i++)
-    {
-      r = RandomNum(state.total);
-      t = state.order[i];
-      state.order[i] = state.order[r];
-      state.order[r] = t;
-    }
+  QuizDeal(&quiz, NextSeed());
+  state.visible = QuizCountVisible(&quiz);
   
-  
-  /* Now point to the first flashcard and then step forward
-   * until we find one that has a positive order[].
-   */
-  
-  state.seen = 0;
-  while (state.order[state.seen] < 0)
-    state.seen++;
+  /* Now point to the first flashcard that isn't hidden. */
+  state.seen = QuizSelect(&quiz, 0);
   
   /* Counter value is one greater than seen. */
   state.curr = 1;
@@ -1955,34 +2080,31 @@ static Err CountRecordsInDB()
 {
     /* Error checking required */
     Err         err = 0;
-    UInt16            i;
-    MemHandle         h;       /* Memory handle to the flashcard DB */
-    DmOpenRef     dbRef;       /* Open ref to the flashcard DB */
-    LocalID        dbID;       /* LocalID of the open DB */
+    LocalID        dbID;       /* LocalID of lampflash.data */
 
 
     /* Adding code to create the "lampflash.data" database 
        if it doesn't exist.  See below.*/
 
     
-    dbID = DmFindDatabase(0, state.dbname);  /* Get dbID of named database */ 
-    
-    if (dbID > 0)
+    /* Open the deck for the rest of the quiz.  It stays open until we
+       leave for the DB form or stop. */
+    flash = &cardNone;
+    if (DeckOpen(&deck, state.dbname) == errNone)
 	{
-	    dbRef = DmOpenDatabase(0, dbID, dmModeReadOnly);
-	    
-	    if (dbRef)
-		{
-		    /* Read the number of records in the DB */
-		    dbnumrec = DmNumRecords(dbRef);
-		    DmCloseDatabase(dbRef);
-		}
+	    /* Read the number of records in the DB */
+	    dbnumrec = deck.numrec;
 
-	    /* Check that the DB does not contain too many records */
+	    /* Set up the quiz order for the DB.  There is no fixed limit
+	       on the size of a deck now - this only fails if we haven't
+	       the memory for it. */
 
-	    if (dbnumrec > MAXNOFLASHCARDS)
+	    QuizFree(&quiz);
+	    if (QuizInit(&quiz, dbnumrec) != errNone)
 		{
 		    /* Too many questions in the database */
+		    FrmAlert(DBTooManyQuestionsAlert);
+		    DeckClose(&deck);
 		    err = 1;
 		}
 
@@ -2013,14 +2135,30 @@ static Err CountRecordsInDB()
 
 
 /*
- * RandomNum()
+ * NewSeed()
+ *
+ * Parameters: None
+ * Returns:    A fresh seed for the random number generator.  This is the
+ *             only place the system's randomness is used - everything
+ *             else comes from state.rng so a quiz can be replayed from
+ *             state.seed.
+ */
+static UInt32 NewSeed(void)
+{
+    return ((UInt32) SysRandom(0) << 16) ^ TimGetTicks();
+}
+
+
+
+/*
+ * NextSeed()
  *
- * Parameters: n - Upper limit of the random number
- * Returns:    Random number
- */ 
-static UInt16 RandomNum(UInt16 n)
+ * Parameters: None
+ * Returns:    Seed for the next deal of the quiz order
+ */
+static UInt32 NextSeed(void)
 {
-    return SysRandom(0) / (1 + sysRandomMax / n);
+    return RndNext(&state.rng);
 }
 
 
@@ -2086,28 +2224,81 @@ static void SetField(FieldPtr field, Char* text, UInt16 memsize)
 
 
 
-/* GetNewFlashcard()
+/* FreeAnswerRoom()
 
    Parameters: None
    Returns:    Nothing */
 
-static void GetNewFlashcard()
+static void FreeAnswerRoom(void)
 {
-    /* Some error checking required */
+    if (pMainWordListPtrArray)
+	MemPtrFree(pMainWordListPtrArray);
+    if (answerwords)
+	MemPtrFree(answerwords);
+    if (answerptrs)
+	MemPtrFree(answerptrs);
+    if (answerpos)
+	MemPtrFree(answerpos);
+    if (answerfound)
+	MemPtrFree(answerfound);
+
+    pMainWordListPtrArray = NULL;
+    answerwords = NULL;
+    answerptrs = NULL;
+    answerpos = NULL;
+    answerfound = NULL;
+    answerroom = 0;
+}
 
-    MemHandle          h; 
-    DmOpenRef      dbRef;
-    LocalID         dbID;
-    Char        tmp[250]; /* buffer to hold the record (flashcard, answers and hooks) */
 
-    /* Loop counters */
-    UInt16        d = 0; /* Loop counter */
-    UInt16       dd = 0; /* loop counter */
 
-    /* Pointers used to traverse the input string */
-    Char* s;
-    Char* t;
-    
+/* AnswerRoom()
+
+   Make room for the answers of a card with n of them, if there isn't
+   already.  Nothing shown is kept - this is for a card about to be
+   shown.
+
+   Parameters: n - answers
+   Returns:    false if there isn't the memory */
+
+static Boolean AnswerRoom(UInt16 n)
+{
+    if (n <= answerroom)
+	return true;
+
+    FreeAnswerRoom();
+    if (n < ANSWERROOM)
+	n = ANSWERROOM;
+
+    pMainWordListPtrArray = MemPtrNew((UInt32) (n + 1) * sizeof(Char *));
+    answerwords = MemPtrNew((UInt32) n * sizeof(*answerwords));
+    answerptrs = MemPtrNew((UInt32) n * sizeof(Char *));
+    answerpos = MemPtrNew((UInt32) n * sizeof(dictPosType));
+    answerfound = MemPtrNew(n * sizeof(Boolean));
+
+    if (!pMainWordListPtrArray || !answerwords || !answerptrs
+	|| !answerpos || !answerfound)
+	{
+	    FreeAnswerRoom();
+	    return false;
+	}
+
+    answerroom = n;
+    return true;
+}
+
+
+
+/* GetNewFlashcard()
+
+   Parameters: None
+   Returns:    Nothing */
+
+static void GetNewFlashcard()
+{
+    const cardType *card;
+    UInt16 n;
+
     /* When restore is true we are about to select the first flashcard
        after powering-on.  The dbcurrec will have been recovered from
        the saved state variables.  
@@ -2116,108 +2307,64 @@ static void GetNewFlashcard()
     */
 
     if (!restore) 
-	{   /* Get the record number of the new flashcard is one less 
-	       then the number in the order array.  NB.  The order array
-	       potentially holds the jumble order of flashcards - and
-	       some negative ones.  Our current flashcard is not state.seen!
+	{   /* Get the record number of the new flashcard from the quiz
+	       order.  Our current flashcard is not state.seen!
 	    */
-	    state.dbcurrec = state.order[state.seen] - 1;
+	    state.dbcurrec = QuizCard(&quiz, state.seen);
 	}    
     
-    /* Query the database for the chosen record */
-    dbID = DmFindDatabase(0, state.dbname);
-    dbRef = NULL;
-    
-    if (dbID > 0)
-	dbRef =  DmOpenDatabase(0, dbID, dmModeReadOnly);
-    
-    if (dbRef)
+    /* Fetch the card from the open deck.  Cards seen recently come
+       straight from the cache. */
+    card = DeckCard(&deck, state.dbcurrec);
+    if (!card)
 	{
-	    h = DmQueryRecord(dbRef, state.dbcurrec);
-	    StrCopy(tmp, MemHandleLock(h));
-	    MemHandleUnlock(h);
-	    DmCloseDatabase(dbRef);
-	    
-	    /* Read in the flashcard question and hooks */
-	    
-	    if (h)
-		{
-		    /*  Reset the flashcard */
-		    StrCopy(flashcard, ""); 
-		    
-		    t = tmp;        /* set input pointer to the string */
-		    s = flashcard;  /* set the output pointer to the flashcard */
-		    
-		    /* -- COLLINS update -- */
-
-		    /* we could check that each character is alphanumeric but that would probably be overkill
-		       afterall that is checked for when creating the databases in the first place.  Probably.
-		       This loose checking allows new Collins words - annotated with "+" - to be shown. */
-
-		    /* It would be nice to add a Preference that can switch on/off
-		       the displaying of "+" characters */
-
-		    /* Parse the flashcard question (alphagram) text from the buffer */ 
-		    while (*t && *t != 9)
-			*(s++) = *(t++);
-		    *s = '\0';
-		    
-		    /* Advance the input pointer beyond the first tab character */
-		    t++;
-
-		    /* get the ANSWERS and hooks */
-		    while (*t)
-			{
-			    s = flash.words[d];  /* reset the output pointer */
-			    while (*t && *t != 47 && *t != 32) /* exists and is not SPACE or '/' */
-				*(s++) = *(t++);
-			    *s = '\0';  /* append terminating NULL */
-			    
-			    if (*t == 47) /* found a '/' */
-				{
-				    /* get the FRONT hooks */
-				    s = flash.front[d];
-				    t++;
-				    while (*t != 47)
-					*(s++) = *(t++) +32;    /* May 3, 2007 - Added +32 to convert hooks to lowercase */
-				    *s = '\0';
-				    
-				    /* get the BACK hooks */
-				    s = flash.back[d];
-				    t++;
-				    while (*t != 47)
-					*(s++) = *(t++) +32;    /* May 3, 2007 - Added +32 to convert hooks to lowercase */
-				    *s = '\0';
-				    
-				    t++;    /* advance the input pointer */
-				    d++;    /* increase the ANSWERS count */
-				}
-			    else
-				{
-				    /* reset the front and back hooks */
-				    StrCopy(flash.front[d], "\0");
-				    StrCopy(flash.back[d], "\0");
+	    /* Record missing or the deck isn't open.  The last card may
+	       have been parsed over in trying so it can't be shown again. */
+	    flash = &cardNone;
+	    flashcard[0] = '\0';
+	    listvalid = false;
+	    return;
+	}
 
-				    if (*t == 32)
-					t++;
-				    d++;    /* increase the ANSWERS count */
-				}
-			}
-		    
-		}
-	    else
-		{
-		    /* Database handle not defined */ 
-		    return;
-		}
+    /* The answers are read from the card where it is but we need our
+       own copy of the flashcard as it gets reordered on screen */
+    flash = card;
+    StrCopy(flashcard, card->question);
+
+    /* A build-up quiz asks for every word of the rack, which the
+       lexicon finds, instead of the deck's answers.  Hook cards are
+       left as they are - their answers are longer than the rack. */
+    if (prefs.buildup && card->count > 0
+	&& StrLen(card->question) == StrLen(card->words[0]) && OpenLexicon()
+	&& CardBuildUp(&lexicon.dawg, card->question, BUILDUPMINLENGTH, &buildup) > 0)
+	flash = &buildup;
+
+    /* Short of memory a card with more answers than any before it
+       shows as many as there's room for - or none, if there's no room
+       at all */
+    for (n = flash->count; n > ANSWERROOM && !AnswerRoom(n); n >>= 1)
+	;
+    if (!AnswerRoom(n))
+	{
+	    trimmed = *flash;
+	    trimmed.count = 0;
+	    flash = &trimmed;
 	}
-    else
+    else if (flash->count > answerroom)
 	{
-	    /* No dbRef for the database */
+	    trimmed = *flash;
+	    trimmed.count = answerroom;
+	    flash = &trimmed;
 	}
+
+    /* The list shows the last card's answers */
+    listvalid = false;
+
+    /* Start reading ahead from here once the user is idle */
+    aheadpos = state.seen;
+    aheadcount = 0;
     
     /* Reset the Bookkeeping variables */
-    flash.count = d;
     revealed = 0;
     clues = 0;
 
@@ -2226,6 +2373,78 @@ static void GetNewFlashcard()
 
     /* save the flashcard as the alphagram */
     StrCopy(alphagram, flashcard);
+
+    /* Its answers are the words likely to be looked up next */
+    PrefetchDefinitions();
+}
+
+
+
+/* PrefetchPending()
+
+   Parameters: None
+   Returns:    true if there are cards still to be read ahead of the
+               current one */
+
+static Boolean PrefetchPending(void)
+{
+    /* Don't read round past the current card in a small quiz */
+    return (deck.ref != NULL && aheadcount < deck.depth 
+	    && aheadcount + 1 < state.visible);
+}
+
+
+
+/* PrefetchNextCard()
+
+   Parameters: None
+   Returns:    Nothing
+
+   Reads the next card of the quiz order into the deck cache.  Called
+   from the event loop when it's idle, a card at a time. */
+
+static void PrefetchNextCard(void)
+{
+    if (!PrefetchPending())
+	return;
+
+    aheadpos = QuizNextVisible(&quiz, aheadpos);
+    DeckPrefetch(&deck, QuizCard(&quiz, aheadpos));
+    aheadcount++;
+}
+
+
+
+/* ShowCacheStats()
+
+   Parameters: None
+   Returns:    Nothing
+
+   Shows how often cards came from the deck cache and how many of
+   those read ahead were used, then how often definitions came from
+   the lookup cache. */
+
+static void ShowCacheStats(void)
+{
+    Char hits[40];
+    Char ahead[40];
+    Char wasted[20];
+
+    StrPrintF(hits, "%lu of %lu (%lu%%)", deck.hits, deck.lookups,
+	      deck.lookups ? deck.hits * 100 / deck.lookups : 0);
+    StrPrintF(ahead, "%lu of %lu (%lu%%)", deck.used, deck.fetched,
+	      deck.fetched ? deck.used * 100 / deck.fetched : 0);
+    StrPrintF(wasted, "%lu", deck.wasted);
+
+    FrmCustomAlert(CacheStatsAlert, hits, ahead, wasted);
+
+    /* And the same for definitions, if any have been looked up */
+    if (defcache.lookups) {
+	StrPrintF(hits, "%lu of %lu (%lu%%)", defcache.hits, defcache.lookups,
+		  defcache.hits * 100 / defcache.lookups);
+	StrPrintF(wasted, "%lu", defcache.bytes);
+	FrmCustomAlert(DefCacheStatsAlert, hits, wasted, "");
+    }
 }
 
 
@@ -2233,7 +2452,7 @@ static void GetNewFlashcard()
 /* SetFlashNumber() 
    - Set the flashcard counter indicator on the main form
  */
-static void SetFlashNumber(UInt16 val)
+static void SetFlashNumber(UInt32 val)
 {
     static Char str[COUNTFIELDSIZE + 1];
     /* If the tmp string buffer isn't being resized why not make it static? */
@@ -2280,7 +2499,7 @@ static void SetCounter(UInt16 c)
 static void InitMainForm()
 {
     /* Initialise MainForm controls */
-    SetCounter(flash.count);
+    SetCounter(flash->count);
 }
 
 
@@ -2391,6 +2610,16 @@ Boolean PrefsFormEventHandler(EventPtr event)
 	    StrCopy(showtilestxt, counteropts[prefs.showtiles]);
 	    CtlSetLabel(pPrefsShowTilesTrig, showtilestxt);
 
+	    LstSetSelection(pPrefsPrefetchList, prefs.prefetchdefs);
+	    LstMakeItemVisible(pPrefsPrefetchList, prefs.prefetchdefs);
+	    StrCopy(prefetchtxt, counteropts[prefs.prefetchdefs]);
+	    CtlSetLabel(pPrefsPrefetchTrig, prefetchtxt);
+
+	    LstSetSelection(pPrefsBuildUpList, prefs.buildup);
+	    LstMakeItemVisible(pPrefsBuildUpList, prefs.buildup);
+	    StrCopy(builduptxt, counteropts[prefs.buildup]);
+	    CtlSetLabel(pPrefsBuildUpTrig, builduptxt);
+
 	    /* Display the form */
 	    FrmDrawForm(pCurForm);
 	    handled = true;
@@ -2414,6 +2643,17 @@ Boolean PrefsFormEventHandler(EventPtr event)
 		    prefs.showcount = LstGetSelection(pPrefsShowCounterList);
 		    prefs.showhooks = LstGetSelection(pPrefsHooksList);
 
+		    /* Turning prefetching on does the card shown now too */
+		    if (!prefs.prefetchdefs && LstGetSelection(pPrefsPrefetchList))
+			{
+			    prefs.prefetchdefs = 1;
+			    PrefetchDefinitions();
+			}
+		    prefs.prefetchdefs = LstGetSelection(pPrefsPrefetchList);
+
+		    /* Build-up starts with the next card */
+		    prefs.buildup = LstGetSelection(pPrefsBuildUpList);
+
 
 		    pCurForm = p;
 		    FrmReturnToForm(0);
@@ -2422,8 +2662,9 @@ Boolean PrefsFormEventHandler(EventPtr event)
 			{
 			    ShowAnswers(revealed, clues);
 			    if (changedTiles == 1) ClearFlashField();
+			    RackInvalidate(&rack);
 			    SetFlashField();
-			    SetCounter(flash.count);
+			    SetCounter(flash->count);
 			}
 
 		    handled = true;
@@ -2454,7 +2695,7 @@ Boolean DictFormEventHandler(EventPtr event)
 {
     Boolean handled = false;  /* Did we handle the event? */
     static FormPtr p;         /* Store the form that launched prefs */
-    Char *textptr, *s, *t, tmp[MAXDBTITLE+1];
+    Char *textptr;
     UInt16 hstart, hend;      /* start and end points of highlighted text */
     
 
@@ -2468,7 +2709,14 @@ Boolean DictFormEventHandler(EventPtr event)
 	FrmDrawForm(pCurForm);
 
 	SetField(pDictInputField, lookup, MAXDBTITLE+1);
-	LookupDefinition(lookup);
+	if (lookupready) {
+	  lookupready = false;
+	  searching = false;
+	  lookupvalid = true;
+	  ShowDefinition();
+	}
+	else
+	  LookupDefinition(lookup);
 	
 	handled = true;
 	break;
@@ -2489,21 +2737,9 @@ Boolean DictFormEventHandler(EventPtr event)
 	  {
 	    FldGetSelection(pDictTextField, &hstart, &hend);
 	    if ((hend-hstart) > 0) {
-	      /* Dictionary has only words upto 8 letters long... */
-	      if (((hend-hstart) > 1 ) && ((hend - hstart) < 9)) {
-		textptr = FldGetTextPtr(pDictTextField);
-		s = tmp;
-		for (t = textptr + hstart; t < (textptr + hend); t++) {
-		  *s++ = *t;
-		}
-		*s = '\0';
-		textptr = NULL;
-		StrCopy(lookup, tmp);
-		CleanUpString(lookup);
-		
-		/* As we are jumping to the word it needs to be written into the input field. */
-		SetField(pDictInputField, lookup, MAXDBTITLE+1);
-		LookupDefinition(lookup);
+	      /* No word is longer than MAXDBTITLE */
+	      if (((hend-hstart) > 1 ) && ((hend - hstart) <= MAXDBTITLE)) {
+		JumpToSelection(hstart, hend);
 	      }
 	      else {
 		FrmAlert(WordTooLong);
@@ -2518,9 +2754,15 @@ Boolean DictFormEventHandler(EventPtr event)
 		StrCopy(lookup, textptr);
 		textptr = NULL;
 	      }
-	      /* cleanup string */
-	      CleanUpString(lookup);
-	      LookupDefinition(lookup);
+	      /* "c?t*" and "=retains?" are searches, anything else a word */
+	      if (SearchParse(lookup, &query) != SEARCHNONE) {
+		SearchDictionary();
+	      }
+	      else {
+		/* cleanup string */
+		CleanUpString(lookup);
+		LookupDefinition(lookup);
+	      }
 	    }
 	    handled = true;
 	    break;
@@ -2528,11 +2770,20 @@ Boolean DictFormEventHandler(EventPtr event)
 	  }
 	if (event->data.ctlSelect.controlID == DictButtonNext)
 	  {
+	    StepDefinition(1);
 	    handled = true;
 	    break;
 	  }
 	if (event->data.ctlSelect.controlID == DictButtonPrev)
 	  {
+	    StepDefinition(-1);
+	    handled = true;
+	    break;
+	  }
+
+	if (event->data.ctlSelect.controlID == DictButtonBack)
+	  {
+	    BackDefinition();
 	    handled = true;
 	    break;
 	  }
@@ -2556,6 +2807,33 @@ Boolean DictFormEventHandler(EventPtr event)
 
 
 	break;
+
+
+	/* Next and Prev as repeating buttons step through the dictionary for
+	   as long as they're held.  The event must not be handled or the
+	   repeating stops. */
+      case ctlRepeatEvent:
+	if (event->data.ctlRepeat.controlID == DictButtonNext)
+	  StepDefinition(1);
+	if (event->data.ctlRepeat.controlID == DictButtonPrev)
+	  StepDefinition(-1);
+	break;
+
+
+	/* Page up and down do the same, repeating while held */
+      case keyDownEvent:
+	if (event->data.keyDown.chr == vchrPageDown)
+	  {
+	    StepDefinition(1);
+	    handled = true;
+	  }
+	if (event->data.keyDown.chr == vchrPageUp)
+	  {
+	    StepDefinition(-1);
+	    handled = true;
+	  }
+	break;
+
       default:
 	break;
 	
@@ -2964,6 +3242,7 @@ Boolean MainFormEventHandler(EventPtr event)
     Int16               val;     /* Repeat value */
     Err                 err;     /* Error code returned by CountRecordsInDB() - if nonzero then DB open failed */
     UInt8 i, j;  /* counter over tiles within the flashcard */
+    Int16 tile;  /* tile tapped */
     Char foo;
     //
     Int16 tmpwordid;
@@ -2986,7 +3265,22 @@ Boolean MainFormEventHandler(EventPtr event)
 		       powering-on, so the state variables are already set.
 		    */
 		    
-		    if (!restore)
+		    if (restore && state.total != quiz.total)
+			restore = false;
+
+		    if (restore)
+			{
+			    /* The order isn't saved with the state - fetch it
+			       from lampflash.data and start afresh if it's
+			       gone.  Having looked once there's no need for
+			       ResetStats() to look again. */
+			    if (!LoadOrderData())
+				{
+				    restore = false;
+				    DefaultStats();
+				}
+			}
+		    else
 			ResetStats();
 		    
 		    if (state.visible > 0)
@@ -3000,7 +3294,7 @@ Boolean MainFormEventHandler(EventPtr event)
 			    
 			    
 			    /* Are we doing anagrams or hooks? */
-			    if (StrLen(flashcard) == StrLen(flash.words[0]))
+			    if (flash == &buildup || StrLen(flashcard) == StrLen(flash->words[0]))
 				doingHooks = false;
 			    else
 				doingHooks = true;
@@ -3021,14 +3315,14 @@ Boolean MainFormEventHandler(EventPtr event)
 			    FldDrawField(pMainDBTitle);
 
 			    SetFlashNumber(state.curr);
-			    SetCounter(flash.count);
+			    SetCounter(flash->count);
 
 
 			    /* Finally, draw the form... */
 			    /* We cannot draw the flashcards by WinDrawChars until
 			       the form has been drawn */
 
-			    SetUpFlashcardField();
+			    RackInvalidate(&rack);
 			    SetFlashField();
 
 			}
@@ -3060,7 +3354,8 @@ Boolean MainFormEventHandler(EventPtr event)
 		  if (tmpwordid != noListSelection)
 		    {
 		      /* Buffer the selected word and copy it to lookup[]. */
-		      StrCopy(tmpword, display[tmpwordid]);
+		      StrNCopy(tmpword, pMainWordListPtrArray[tmpwordid], MAXDBTITLE);
+		      tmpword[MAXDBTITLE] = '\0';
 		      
 		      for (i = 0; i < StrLen(tmpword); i++) {
 			if ( ((tmpword[i] > 64) && (tmpword[i] < 91)) ||
@@ -3074,6 +3369,13 @@ Boolean MainFormEventHandler(EventPtr event)
 
 		      /* Convert the lookup string to lowercase */
 		      StrToLower(lookup, tmpword);
+
+		      /* An answer found as the card loaded needs no search.
+			 (The clue row only shows part of its answer.) */
+		      lookupready = (tmpwordid < flash->count && answerfound[tmpwordid]
+				     && StrCompare(lookup, answerwords[tmpwordid]) == 0);
+		      if (lookupready)
+			lookuppos = answerpos[tmpwordid];
 		      
 		      FrmPopupForm(DictForm);
 		    }
@@ -3088,62 +3390,37 @@ Boolean MainFormEventHandler(EventPtr event)
 		    {
 			if (INFLASHCARD(event->screenY))
 			    {
-				/* This could be reworked for more efficiency */
-
-				for (i = 0; i < StrLen(flashcard); i++)
+				tile = RackHit(&rack, event->screenX);
+				if (tile >= 0)
 				    {
-					if ((event->screenX > rack[i].topLeft.x) && 
-					    (event->screenX < rack[i].topLeft.x + rack[i].extent.x))
+					if (highlight < 0)
 					    {
 						/* Nothing highlighted */
-						if (highlight < 0)
-						    {
-							DrawTile(rack[i], flashcard[i], 1);
-							highlight = i;
-							handled = true;
-							break;
-						    }
+						highlight = tile;
+					    }
+					else if (highlight == tile) 
+					    {
+						highlight = -1;
+					    }
+					else
+					    {
+						/* Move the highlighted tile to
+						   here, sliding the ones between
+						   along one */
+						foo = flashcard[highlight];
+						if (highlight > tile)
+						    for (j = highlight; j > tile; j--)
+							flashcard[j] = flashcard[j-1];
 						else
-						    {
-							if (highlight == i) 
-							    {
-								highlight = -1;
-								DrawTile(rack[i], flashcard[i], 0);
-								handled = true;
-								break;
-							    }
-
-							/* otherwise swap */
-							foo = flashcard[highlight];
-							if (highlight > i)
-							    {
-								for (j = highlight; j > i; j--)
-								    {
-									flashcard[j] = flashcard[j-1];
-									DrawTile(rack[j], flashcard[j], 0);
-								    }
-								flashcard[i] = foo;
-								DrawTile(rack[i], flashcard[i], 0);
-								highlight = -1;
-								handled = true;
-							    }
-							else
-							    {
-								for (j = highlight; j < i; j++)
-								    {
-									flashcard[j] = flashcard[j+1];
-									DrawTile(rack[j], flashcard[j], 0);
-								    }
-								flashcard[i] = foo;
-								DrawTile(rack[i], flashcard[i], 0);
-								highlight = -1;
-								handled = true;
-								break;
-							    }
-
-						    }
-
+						    for (j = highlight; j < tile; j++)
+							flashcard[j] = flashcard[j+1];
+						flashcard[tile] = foo;
+						highlight = -1;
 					    }
+
+					/* Only the tiles that changed are drawn */
+					RackDraw(&rack, flashcard, highlight);
+					handled = true;
 				    }
 				break;
 			    }
@@ -3398,6 +3675,9 @@ Boolean MainFormEventHandler(EventPtr event)
 		    val = -val;
 		}
 	    LstScrollList(pMainWordList, dir, val);
+
+	    /* The list isn't where ShowAnswers() left it */
+	    listvalid = false;
 	    break;
 	    
 	    
@@ -3411,6 +3691,9 @@ Boolean MainFormEventHandler(EventPtr event)
 		case HelpMenuNewDB:
 		    /* Save lampflash.data before exiting form */
 		    SaveOrderData();
+		    QuizFree(&quiz);
+		    flash = &cardNone;
+		    DeckClose(&deck);
 		    FrmGotoForm(DBForm); 
 		    break;
 
@@ -3436,6 +3719,10 @@ Boolean MainFormEventHandler(EventPtr event)
 		    FrmCustomAlert(AboutAlert, version, NULL, NULL);
 		    break;
 
+		case HelpMenuStats:
+		    ShowCacheStats();
+		    break;
+
 		case HelpMenuPrefs:
 		    FrmPopupForm(PrefsForm);
 		    break;
@@ -3489,6 +3776,7 @@ static Boolean AppEventHandler(EventPtr event)
 			FrmGetObjectPtr(form, FrmGetObjectIndex(form, MainDBTitle));
 		    pMainWordList = 
 			FrmGetObjectPtr(form, FrmGetObjectIndex(form, MainWordList));
+		    LstSetDrawFunction(pMainWordList, DrawAnswerRow);
 		    pMainScrollBar = 
 			FrmGetObjectPtr(form, FrmGetObjectIndex(form, MainWordScroll));
 		    pMainAnswers = 
@@ -3543,6 +3831,14 @@ static Boolean AppEventHandler(EventPtr event)
 			FrmGetObjectPtr(form, FrmGetObjectIndex(form, ShowTilesTrig));
 		    pPrefsShowTilesList = 
 			FrmGetObjectPtr(form, FrmGetObjectIndex(form, ShowTilesList));
+		    pPrefsPrefetchTrig = 
+			FrmGetObjectPtr(form, FrmGetObjectIndex(form, PrefetchTrig));
+		    pPrefsPrefetchList = 
+			FrmGetObjectPtr(form, FrmGetObjectIndex(form, PrefetchList));
+		    pPrefsBuildUpTrig = 
+			FrmGetObjectPtr(form, FrmGetObjectIndex(form, BuildUpTrig));
+		    pPrefsBuildUpList = 
+			FrmGetObjectPtr(form, FrmGetObjectIndex(form, BuildUpList));
 		    
 		    /* Declare the event handler */
 		    FrmSetEventHandler(form, PrefsFormEventHandler);
@@ -3600,6 +3896,8 @@ static Boolean AppEventHandler(EventPtr event)
 static void StopApplication(void)
 {
     /* Perform deinitialisation when the program ends */
+    RackFree(&rack);
+
     if (dbh)
 	{
 	    MemHandleUnlock(dbh);  
@@ -3616,6 +3914,20 @@ static void StopApplication(void)
 	    MemHandleFree(ppah);
 	}
     
+    /* The quiz order is only set up while a quiz is running.  Save it to
+       lampflash.data so that we can restore it next time. */
+    if (quiz.total > 0)
+	{
+	    SaveOrderData();
+	    QuizFree(&quiz);
+	}
+    DeckClose(&deck);
+    DictClose(&dict);
+    DefCacheFree(&defcache);
+    LexiconClose(&lexicon);
+    CardFree(&buildup);
+    FreeAnswerRoom();
+
     PrefSetAppPreferences(CREATORID, PREFSID, PREFSVERSION, &prefs, sizeof(prefsType), true);
     PrefSetAppPreferences(CREATORID, STATEID, STATEVERSION, &state, sizeof(stateType), false);
 
@@ -3649,6 +3961,8 @@ static Err StartApplication(void)
     /* Copy the version string from VersionStr defined in .rcp file */
     SysCopyStringResource(version, VersionStr);
     
+    /* Nothing drawn in the rack yet */
+    RackInit(&rack);
 
     /* -----------------------------
        Read and restore PREFERENCES 
@@ -3688,6 +4002,8 @@ static Err StartApplication(void)
 	    MemSet(&state, sizeof(stateType), 0);
 	    //	    StrCopy(state.dbname, "\0");
 	    state.noCurrDB = 1;  /* there is no current DB */ 
+	    state.seed = NewSeed();
+	    RndSeed(&state.rng, state.seed);
 	    FrmGotoForm(DBForm);
 	}
     else
@@ -3735,7 +4051,12 @@ static void EventLoop(void)
     
     do
 	{
-	    EvtGetEvent(&e, evtWaitForever);
+	    /* Don't sleep while there are cards to read ahead - we get
+	       a nilEvent as soon as the queue is empty */
+	    EvtGetEvent(&e, PrefetchPending() ? 0 : evtWaitForever);
+
+	    if (e.eType == nilEvent)
+		PrefetchNextCard();
 	    
 	    if (! SysHandleEvent(&e))
 		if (! MenuHandleEvent(0, &e, &error))
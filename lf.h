@@ -2,9 +2,14 @@
 
 /* Cannot get the PalmChars.h stuff to work properly on both the TX and older palms */
 
-#define MAXDISPLAYSIZE  25     /* Max number of answers to each question... for displaying */
-#define MAXNOFLASHCARDS 250    /* Number of alphagram questions.  50-100 is best. */
-#define COUNTFIELDSIZE 9       /* Size of the counter text field */
+/* My creator ID is registered with Palm via Access - see the website
+   (http://www.access-company.com/developers/index.html) */
+#define CREATORID        'shLF'   
+
+/* NOTE - if you change MAXDBTITLE you will alter the size of the prefs structure
+   and so the prefs version number must be incremented. */
+#define MAXDBTITLE     32      /* DB names, and the longest dictionary word */
+#define COUNTFIELDSIZE 11      /* Size of the counter text field - "65535/65535" */
 
 #define LISTSIZE 7             /* Lines in the main word solution window */
 #define DBLISTMAX 9           /* Lines in the DB selection window */
@@ -52,6 +57,7 @@
 #define HelpMenuPrefs         1114  /* Launch prefs form */
 #define HelpMenuInst          1115  /* Instructions */
 #define HelpMenuAbout         1116  /* Display the about page */
+#define HelpMenuStats         1117  /* Card cache and read ahead counters */
 
 /* OPTIONS menu */
 
@@ -71,6 +77,10 @@
 #define HooksList             1133
 #define ShowTilesTrig         1134
 #define ShowTilesList         1135
+#define PrefetchTrig          1136  /* Find the answers in the dictionary as cards load */
+#define PrefetchList          1137
+#define BuildUpTrig           1138  /* Ask for every word of the rack, from the lexicon */
+#define BuildUpList           1139
 
 
 /* Dictionary form definitions */
@@ -82,6 +92,7 @@
 #define DictInputField        1414
 #define DictButtonPrev        1415
 #define DictButtonNext        1416
+#define DictButtonBack        1417
 
 
 
@@ -126,6 +137,8 @@
 #define DBOrderOpenFailed     1207
 #define NoDictDatabase        1208
 #define WordTooLong           1209
+#define CacheStatsAlert       1210  /* "Cache hits ^1 / Read ahead used ^2 / wasted ^3" */
+#define DefCacheStatsAlert    1211  /* "Definitions from the cache ^1 / bytes held ^2" */
 
 
 // Debug stuff
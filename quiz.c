@@ -0,0 +1,546 @@
+/* -----------------------------------------------------------------------------
+   Quiz order engine for LAMPFlash.
+
+   A deal is a Fisher-Yates shuffle of the cards in it, run lazily: the
+   swap for position i is only made when the quiz first reaches position
+   i.  The order is held in fixed size pages so that no single allocation
+   grows beyond what the Palm heap will give us, and a page is only
+   filled in when a swap first touches it.  Dealing is then just a matter
+   of marking every page untouched.
+
+   Two bitvectors go with the order.  The card bits say which cards are
+   in the current deal, so cards deleted in an earlier deal are left out
+   of the next one.  The shown bits say which positions of the current
+   deal have not been deleted.  Both are grouped into blocks of
+   QUIZBLOCKWORDS words with a Fenwick tree of the number of set bits in
+   each block, so counting (rank) and finding (select) set bits costs a
+   walk down the tree plus a popcount over at most one block.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "quiz.h"
+
+
+#define BIT(i)          (1UL << ((i) & 31))
+#define LOWBIT(i)       ((i) & (~(i) + 1))
+
+/* The 68k has no popcount instruction so count a byte at a time */
+static const UInt8 bitsSet[256] =
+{
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7,
+  4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8
+};
+
+#define POP32(w)  (bitsSet[(w) & 0xff] + bitsSet[((w) >> 8) & 0xff] + \
+                   bitsSet[((w) >> 16) & 0xff] + bitsSet[(w) >> 24])
+
+
+
+/* Position of the k-th (from 0) set bit of w */
+static UInt16 SelectInWord(UInt32 w, UInt32 k)
+{
+  UInt16 shift = 0;
+  UInt8 c;
+
+  /* Skip whole bytes first */
+  while ((c = bitsSet[(w >> shift) & 0xff]) <= k)
+    {
+      k -= c;
+      shift += 8;
+    }
+
+  /* Then bits within the byte */
+  for (;; shift++)
+    {
+      if ((w >> shift) & 1)
+	{
+	  if (k == 0)
+	    break;
+	  k--;
+	}
+    }
+
+  return shift;
+}
+
+
+
+/* BITVECTORS */
+
+
+/* Allocate room for n bits in whole blocks so a block scan never runs
+   off the end.  Bits beyond the length in use are always kept clear. */
+static Err BitsAlloc(quizBitsType *b, UInt32 n)
+{
+  b->nblocks = QuizBlockCount(n);
+  b->length = 0;
+  b->ones = 0;
+  b->words = (UInt32 *) MemPtrNew(b->nblocks * QUIZBLOCKWORDS * sizeof(UInt32));
+  b->counts = (UInt32 *) MemPtrNew(b->nblocks * sizeof(UInt32));
+
+  if (b->words == NULL || b->counts == NULL)
+    return memErrNotEnoughSpace;
+
+  return errNone;
+}
+
+
+static void BitsFree(quizBitsType *b)
+{
+  if (b->words)
+    MemPtrFree(b->words);
+  if (b->counts)
+    MemPtrFree(b->counts);
+
+  MemSet(b, sizeof(quizBitsType), 0);
+}
+
+
+/* Rebuild the block counts from the bits, clearing any beyond the
+   length in use first */
+static void BitsRecount(quizBitsType *b)
+{
+  UInt32 words = QuizWordCount(b->length);
+  UInt32 i, j, n;
+
+  MemSet(b->words + words, (b->nblocks * QUIZBLOCKWORDS - words) * sizeof(UInt32), 0);
+  if (b->length & 31)
+    b->words[words - 1] &= BIT(b->length) - 1;
+
+  b->ones = 0;
+
+  for (i = 0; i < b->nblocks; i++)
+    {
+      n = 0;
+      for (j = i << QUIZBLOCKSHIFT; j < (i + 1) << QUIZBLOCKSHIFT; j++)
+	n += POP32(b->words[j]);
+      b->counts[i] = n;
+      b->ones += n;
+    }
+
+  /* Turn the per-block counts into a Fenwick tree in place */
+  for (i = 1; i <= b->nblocks; i++)
+    {
+      j = i + LOWBIT(i);
+      if (j <= b->nblocks)
+	b->counts[j - 1] += b->counts[i - 1];
+    }
+}
+
+
+/* Set the first length bits and clear the rest - a word at a time */
+static void BitsFill(quizBitsType *b, UInt32 length)
+{
+  b->length = length;
+  MemSet(b->words, QuizWordCount(length) * sizeof(UInt32), 0xff);
+  BitsRecount(b);
+}
+
+
+static Boolean BitsTest(const quizBitsType *b, UInt32 i)
+{
+  return (b->words[i >> 5] & BIT(i)) != 0;
+}
+
+
+/* Clear bit i and take it off the count of its block */
+static void BitsClear(quizBitsType *b, UInt32 i)
+{
+  UInt32 k;
+
+  if (BitsTest(b, i))
+    {
+      b->words[i >> 5] &= ~BIT(i);
+      for (k = (i >> (5 + QUIZBLOCKSHIFT)) + 1; k <= b->nblocks; k += LOWBIT(k))
+	b->counts[k - 1]--;
+      b->ones--;
+    }
+}
+
+
+/* Number of set bits before bit i */
+static UInt32 BitsRank(const quizBitsType *b, UInt32 i)
+{
+  UInt32 w = i >> 5;
+  UInt32 k, n = 0;
+
+  for (k = w >> QUIZBLOCKSHIFT; k > 0; k -= LOWBIT(k))
+    n += b->counts[k - 1];
+
+  for (k = w & ~(UInt32) (QUIZBLOCKWORDS - 1); k < w; k++)
+    n += POP32(b->words[k]);
+
+  if (i & 31)
+    n += POP32(b->words[w] & (BIT(i) - 1));
+
+  return n;
+}
+
+
+/* Position of the k-th (from 0) set bit.  k must be less than the
+   number of bits set. */
+static UInt32 BitsSelect(const quizBitsType *b, UInt32 k)
+{
+  UInt32 blk = 0, step, w, c;
+
+  /* Walk down the Fenwick tree to the block holding the bit */
+  for (step = 1; (step << 1) <= b->nblocks; step <<= 1)
+    ;
+  for (; step > 0; step >>= 1)
+    {
+      if (blk + step <= b->nblocks && b->counts[blk + step - 1] <= k)
+	{
+	  blk += step;
+	  k -= b->counts[blk - 1];
+	}
+    }
+
+  /* Then along the words of the block */
+  for (w = blk << QUIZBLOCKSHIFT; ; w++)
+    {
+      c = POP32(b->words[w]);
+      if (k < c)
+	break;
+      k -= c;
+    }
+
+  return (w << 5) + SelectInWord(b->words[w], k);
+}
+
+
+/* Position of the first set bit after bit i.  There must be one. */
+static UInt32 BitsNext(const quizBitsType *b, UInt32 i)
+{
+  UInt32 w = ++i >> 5;
+  UInt32 x = b->words[w] & ~(BIT(i) - 1);
+
+  while (x == 0)
+    x = b->words[++w];
+
+  return (w << 5) + SelectInWord(x, 0);
+}
+
+
+
+/* THE ORDER */
+
+
+/* The generator is seeded afresh for every deal so that the deal can be
+   replayed from its seed alone */
+static void QuizSeed(quizType *q, UInt32 seed)
+{
+  q->seed = seed;
+  RndSeed(&q->rng, seed);
+}
+
+
+/* Entry of the order at pos.  A page untouched by the deal so far
+   holds the cards of the deal in card number order, so it's filled in
+   with those the first time we look at it. */
+static CardIdx *QuizEntry(quizType *q, UInt32 pos)
+{
+  UInt16 p = pos >> QUIZPAGESHIFT;
+  CardIdx *e = q->pages[p];
+  UInt32 first, n, i, c;
+
+  if (!q->ready[p])
+    {
+      first = (UInt32) p << QUIZPAGESHIFT;
+      n = q->size - first;
+      if (n > QUIZPAGESIZE)
+	n = QUIZPAGESIZE;
+
+      if (q->cards.ones == q->total)
+	{
+	  /* Every card is dealt so the card is the position */
+	  for (i = 0; i < n; i++)
+	    e[i] = first + i;
+	}
+      else
+	{
+	  c = BitsSelect(&q->cards, first);
+	  for (i = 0; i < n; i++)
+	    {
+	      e[i] = c;
+	      if (i + 1 < n)
+		c = BitsNext(&q->cards, c);
+	    }
+	}
+
+      q->ready[p] = 1;
+    }
+
+  return &e[pos & QUIZPAGEMASK];
+}
+
+
+/* Draw the next position of the deal - one step of Fisher-Yates */
+static void QuizDraw(quizType *q)
+{
+  UInt32 i = q->cursor;
+  UInt32 j = i + RndBounded(&q->rng, q->size - i);
+  CardIdx *ei, *ej, t;
+
+  ei = QuizEntry(q, i);
+  ej = QuizEntry(q, j);
+  t = *ei;
+  *ei = *ej;
+  *ej = t;
+
+  q->cursor++;
+}
+
+
+
+/* Allocate the order for a deck of total cards with every card
+   included but nothing dealt.  Returns nonzero if there are more
+   cards than a DB can hold or we ran out of memory, in which case
+   nothing is left allocated. */
+Err QuizInit(quizType *q, UInt32 total)
+{
+  UInt16 p;
+
+  MemSet(q, sizeof(quizType), 0);
+
+  if (total == 0)
+    return errNone;
+  if (total > 0xFFFFUL)
+    return memErrNotEnoughSpace;
+
+  q->pages = (CardIdx **) MemPtrNew(QuizPageCount(total) * sizeof(CardIdx *));
+  q->ready = (UInt8 *) MemPtrNew(QuizPageCount(total));
+  if (q->pages == NULL || q->ready == NULL)
+    {
+      QuizFree(q);
+      return memErrNotEnoughSpace;
+    }
+
+  for (p = 0; p < QuizPageCount(total); p++)
+    {
+      q->pages[p] = (CardIdx *) MemPtrNew(QUIZPAGESIZE * sizeof(CardIdx));
+      if (q->pages[p] == NULL)
+	{
+	  QuizFree(q);
+	  return memErrNotEnoughSpace;
+	}
+      q->npages++;
+    }
+
+  if (BitsAlloc(&q->cards, total) != errNone ||
+      BitsAlloc(&q->shown, total) != errNone)
+    {
+      QuizFree(q);
+      return memErrNotEnoughSpace;
+    }
+
+  q->total = total;
+  BitsFill(&q->cards, total);
+  BitsFill(&q->shown, 0);
+  MemSet(q->ready, q->npages, 0);
+
+  return errNone;
+}
+
+
+
+void QuizFree(quizType *q)
+{
+  UInt16 p;
+
+  if (q->pages)
+    {
+      for (p = 0; p < q->npages; p++)
+	MemPtrFree(q->pages[p]);
+      MemPtrFree(q->pages);
+    }
+  if (q->ready)
+    MemPtrFree(q->ready);
+
+  BitsFree(&q->cards);
+  BitsFree(&q->shown);
+
+  MemSet(q, sizeof(quizType), 0);
+}
+
+
+
+/* Start a new deal of the cards still visible.  Cards deleted from
+   the current deal are dropped from the card bits first. */
+void QuizDeal(quizType *q, UInt32 seed)
+{
+  UInt32 w, z, pos, last = 0;
+  Boolean hidden = false;
+
+  if (q->total == 0)
+    return;
+
+  if (q->shown.ones < q->size)
+    {
+      /* Every deleted position has to have been drawn before we can
+	 tell which card it was.  Draw them all before touching the card
+	 bits, as drawing may fill in pages from them. */
+      for (w = 0; w < QuizWordCount(q->size); w++)
+	{
+	  z = ~q->shown.words[w];
+	  if (((w + 1) << 5) > q->size)
+	    z &= BIT(q->size) - 1;
+	  if (z)
+	    {
+	      last = w;
+	      hidden = true;
+	    }
+	}
+      if (hidden)
+	QuizCard(q, (last << 5) + 31 < q->size ? (last << 5) + 31 : q->size - 1);
+
+      for (w = 0; w < QuizWordCount(q->size); w++)
+	{
+	  z = ~q->shown.words[w];
+	  if (((w + 1) << 5) > q->size)
+	    z &= BIT(q->size) - 1;
+	  while (z)
+	    {
+	      pos = (w << 5) + SelectInWord(z, 0);
+	      BitsClear(&q->cards, *QuizEntry(q, pos));
+	      z &= z - 1;
+	    }
+	}
+    }
+
+  q->size = q->cards.ones;
+  q->cursor = 0;
+  QuizSeed(q, seed);
+  MemSet(q->ready, q->npages, 0);
+  BitsFill(&q->shown, q->size);
+}
+
+
+/* Put every card back in the quiz with a new deal and return the
+   number of visible cards */
+UInt32 QuizUnhideAll(quizType *q, UInt32 seed)
+{
+  if (q->total == 0)
+    return 0;
+
+  BitsFill(&q->cards, q->total);
+  q->size = 0;
+  BitsFill(&q->shown, 0);
+  QuizDeal(q, seed);
+
+  return q->shown.ones;
+}
+
+
+
+/* Card at position pos of the deal, drawing up to it if need be */
+CardIdx QuizCard(quizType *q, UInt32 pos)
+{
+  while (q->cursor <= pos)
+    QuizDraw(q);
+
+  return *QuizEntry(q, pos);
+}
+
+
+Boolean QuizIsHidden(const quizType *q, UInt32 pos)
+{
+  return !BitsTest(&q->shown, pos);
+}
+
+
+void QuizHide(quizType *q, UInt32 pos)
+{
+  BitsClear(&q->shown, pos);
+}
+
+
+UInt32 QuizCountVisible(const quizType *q)
+{
+  return q->shown.ones;
+}
+
+
+
+/* Number of visible cards before position pos */
+UInt32 QuizRank(const quizType *q, UInt32 pos)
+{
+  return BitsRank(&q->shown, pos);
+}
+
+
+/* Position of the k-th (from 0) visible card.  k must be less than the
+   number of visible cards. */
+UInt32 QuizSelect(const quizType *q, UInt32 k)
+{
+  return BitsSelect(&q->shown, k);
+}
+
+
+/* Step forward from pos to the next card that isn't hidden, looping
+   around the end of the deal.  There must be at least one visible card. */
+UInt32 QuizNextVisible(const quizType *q, UInt32 pos)
+{
+  UInt32 r = (pos + 1 < q->size) ? QuizRank(q, pos + 1) : q->shown.ones;
+
+  return QuizSelect(q, r < q->shown.ones ? r : 0);
+}
+
+
+/* Similar to QuizNextVisible() above */
+UInt32 QuizPrevVisible(const quizType *q, UInt32 pos)
+{
+  UInt32 r = QuizRank(q, pos);
+
+  return QuizSelect(q, (r > 0 ? r : q->shown.ones) - 1);
+}
+
+
+
+UInt32 *QuizCardBits(const quizType *q)
+{
+  return q->cards.words;
+}
+
+
+UInt32 *QuizShownBits(const quizType *q)
+{
+  return q->shown.words;
+}
+
+
+/* Rebuild a saved deal from its seed once the card and shown bits have
+   been read back.  Fails if the bits don't agree with the deal. */
+Err QuizRestore(quizType *q, UInt32 seed, UInt32 size, UInt32 cursor)
+{
+  q->cards.length = q->total;
+  BitsRecount(&q->cards);
+  q->shown.length = size;
+  BitsRecount(&q->shown);
+
+  if (q->cards.ones != size || cursor > size)
+    return dmErrCorruptDatabase;
+
+  q->size = size;
+  q->cursor = 0;
+  QuizSeed(q, seed);
+  MemSet(q->ready, q->npages, 0);
+
+  while (q->cursor < cursor)
+    QuizDraw(q);
+
+  return errNone;
+}
@@ -0,0 +1,91 @@
+/* Quiz order engine - holds the running order of a flashcard deck and
+   which of its cards are still visible (not deleted).
+
+   The order used to live in fixed Int16 arrays in stateType and
+   dbOrderType, which capped a deck at 250 cards.  It is now kept in
+   pages of QUIZPAGESIZE cards, allocated when the deck is opened, so no
+   one allocation outgrows the heap.  A deck can have as many cards as a
+   DB has records (65535) if there is the memory for it: the order takes
+   two bytes a card, and every page is needed once the quiz is under way
+   since a deal swaps cards in from anywhere in the deck.  On a device
+   with a small dynamic heap QuizInit() fails well before that.
+
+   Each shuffle ("deal") is a lazy Fisher-Yates permutation of the cards
+   visible at the time.  Positions are drawn from a seeded generator only
+   as the quiz reaches them, so dealing costs nothing up front and the
+   order can be saved as the seed and the number of positions drawn.
+
+   Cards deleted during a deal are cleared in a bitvector over positions
+   with a running count per block of bits, so finding the next visible
+   card or the number of the current card is a rank/select rather than a
+   walk over every hidden card. */
+
+#ifndef QUIZ_H
+#define QUIZ_H
+
+#include "rand.h"
+
+/* Card numbers are record indices within the flashcard DB */
+typedef UInt16 CardIdx;
+
+/* Entries per page of the order */
+#define QUIZPAGESHIFT       12
+#define QUIZPAGESIZE        (1UL << QUIZPAGESHIFT)
+#define QUIZPAGEMASK        (QUIZPAGESIZE - 1)
+
+/* Bits are counted in blocks of this many 32-bit words */
+#define QUIZBLOCKSHIFT      3
+#define QUIZBLOCKWORDS      (1 << QUIZBLOCKSHIFT)
+
+#define QuizPageCount(n)    (((n) + QUIZPAGESIZE - 1) >> QUIZPAGESHIFT)
+#define QuizWordCount(n)    (((n) + 31) >> 5)
+#define QuizBlockCount(n)   ((QuizWordCount(n) + QUIZBLOCKWORDS - 1) >> QUIZBLOCKSHIFT)
+
+/* quizBitsType - a bitvector with a Fenwick tree of set bits per block */
+typedef struct
+{
+  UInt32       *words;
+  UInt32       *counts;   /* Fenwick tree of set bits per block */
+  UInt32        nblocks;  /* Blocks allocated */
+  UInt32        length;   /* Bits in use */
+  UInt32        ones;     /* Bits set */
+} quizBitsType;
+
+/* quizType - the order and visibility of a deck of total cards. */
+typedef struct
+{
+  UInt32        total;    /* Number of cards in the deck */
+  UInt32        size;     /* Number of cards in the current deal */
+  UInt32        seed;     /* Seed the current deal was drawn from */
+  rngType       rng;      /* Generator state after cursor draws */
+  UInt32        cursor;   /* Positions of the deal drawn so far */
+  UInt16        npages;   /* Number of allocated pages */
+  CardIdx     **pages;    /* The order - the card at each position */
+  UInt8        *ready;    /* Pages touched by the current deal */
+  quizBitsType  cards;    /* Cards in the current deal, by card number */
+  quizBitsType  shown;    /* Positions not deleted since the deal */
+} quizType;
+
+Err     QuizInit(quizType *q, UInt32 total);
+void    QuizFree(quizType *q);
+
+void    QuizDeal(quizType *q, UInt32 seed);
+UInt32  QuizUnhideAll(quizType *q, UInt32 seed);
+
+CardIdx QuizCard(quizType *q, UInt32 pos);
+Boolean QuizIsHidden(const quizType *q, UInt32 pos);
+void    QuizHide(quizType *q, UInt32 pos);
+UInt32  QuizCountVisible(const quizType *q);
+
+UInt32  QuizRank(const quizType *q, UInt32 pos);
+UInt32  QuizSelect(const quizType *q, UInt32 k);
+UInt32  QuizNextVisible(const quizType *q, UInt32 pos);
+UInt32  QuizPrevVisible(const quizType *q, UInt32 pos);
+
+/* Saving and restoring.  Fill the card bits (total bits) and the shown
+   bits (size bits) then call QuizRestore() to replay the deal. */
+UInt32 *QuizCardBits(const quizType *q);
+UInt32 *QuizShownBits(const quizType *q);
+Err     QuizRestore(quizType *q, UInt32 seed, UInt32 size, UInt32 cursor);
+
+#endif
@@ -0,0 +1,237 @@
+/* -----------------------------------------------------------------------------
+   Flashcard rack drawing for LAMPFlash.
+
+   The glyph cache is a single offscreen window holding a plain and a
+   highlighted tile for every letter, side by side.  A tile is only drawn
+   into it the first time that letter is needed, and from then on
+   putting the tile on screen is one WinCopyRectangle().  If there isn't
+   the memory for the window the tiles are drawn directly as before.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "rack.h"
+
+
+
+/* Draw a tile with letter c in rec, inverted if border is set */
+static void RackDrawTile(RectangleType rec, Char c, UInt8 border)
+{
+  RectangleType rp = rec;
+  FontID  oldfont;
+
+  /* Draw a black rectangle */
+  WinDrawRectangle(&rp, 3);
+
+  /* Resize the rectangle by one pixel on each side
+     and move the rectangle so it is centred in the middle
+     of the one drawn above. */
+  rp.topLeft.x ++;
+  rp.topLeft.y ++;
+  rp.extent.x -= 2;
+  rp.extent.y -= 2;
+
+  /* Remove the inner rectangle - or draw a while rectangle */
+  if (!border)
+    WinEraseRectangle(&rp, 3);
+
+  /* The fonts don't display the way we'd like so they
+     may need shifting a little.  Offending letters are those
+     of the new Collins word WAI (meaning water). */
+  if (c == 'I') rp.topLeft.x++;
+  if (c == 'A' || c == 'W') rp.topLeft.x--;
+
+  /* Save the current font and reset the font to largeBold */
+  oldfont = FntSetFont(largeBoldFont);
+
+  /* Draw the letter in the rectangle */
+  if (border)
+    WinDrawInvertedChars(&c, 1, rp.topLeft.x + 3, rp.topLeft.y);
+  else
+    WinDrawChar(c, rp.topLeft.x + 3, rp.topLeft.y);
+
+  /* Reset the current font to whatever it was. */
+  FntSetFont(oldfont);
+}
+
+
+
+/* Find the tile for c in the glyph cache, drawing it there if it's the
+   first time it's been asked for.  Returns false if it can't be cached
+   and has to be drawn directly. */
+static Boolean RackGlyph(rackType *r, Char c, Boolean lit, RectangleType *src)
+{
+  WinHandle old;
+  UInt16 err, i;
+  UInt32 bit;
+
+  /* The letters, then the blank */
+  if (c >= 'A' && c <= 'Z')
+    i = c - 'A';
+  else if (c == '?')
+    i = 26;
+  else
+    return false;
+
+  if (r->noglyphs)
+    return false;
+
+  if (!r->glyphs)
+    {
+      r->glyphs = WinCreateOffscreenWindow(RACKGLYPHS * TILEWIDTH, 2 * TILEHEIGHT,
+					   screenFormat, &err);
+      if (!r->glyphs)
+	{
+	  r->noglyphs = true;
+	  return false;
+	}
+      r->ready[0] = r->ready[1] = 0;
+    }
+
+  src->topLeft.x = i * TILEWIDTH;
+  src->topLeft.y = lit ? TILEHEIGHT : 0;
+  src->extent.x = TILEWIDTH;
+  src->extent.y = TILEHEIGHT;
+
+  bit = 1UL << i;
+  if (!(r->ready[lit] & bit))
+    {
+      old = WinSetDrawWindow(r->glyphs);
+      WinEraseRectangle(src, 0);
+      RackDrawTile(*src, c, lit);
+      WinSetDrawWindow(old);
+
+      r->ready[lit] |= bit;
+    }
+
+  return true;
+}
+
+
+
+/* Put the tile for c in slot i of the rack */
+static void RackTile(rackType *r, UInt16 i, Char c, Boolean lit)
+{
+  RectangleType src;
+
+  if (RackGlyph(r, c, lit, &src))
+    WinCopyRectangle(r->glyphs, WinGetDrawWindow(), &src,
+		     r->tile[i].topLeft.x, r->tile[i].topLeft.y, winPaint);
+  else
+    RackDrawTile(r->tile[i], c, lit);
+}
+
+
+
+/* Work out where each of len tiles goes.  xoffset is the midpoint minus
+   half the width of the rack and we assume the X midpoint is at 79 (or
+   so). */
+static void RackLayout(rackType *r, UInt16 len)
+{
+  Coord xoffset = 79 - len * (TILEWIDTH + TILESPACE) / 2;
+  UInt16 i;
+
+  r->len = len;
+  for (i = 0; i < len; i++)
+    {
+      r->tile[i].topLeft.x = xoffset + i * (TILEWIDTH + TILESPACE);
+      r->tile[i].topLeft.y = YOFFSET;
+      r->tile[i].extent.x = TILEWIDTH;
+      r->tile[i].extent.y = TILEHEIGHT;
+    }
+}
+
+
+
+void RackInit(rackType *r)
+{
+  MemSet(r, sizeof(rackType), 0);
+}
+
+
+
+/* Free the glyph cache */
+void RackFree(rackType *r)
+{
+  if (r->glyphs)
+    WinDeleteWindow(r->glyphs, false);
+
+  r->glyphs = NULL;
+  r->noglyphs = false;
+  r->valid = false;
+}
+
+
+
+/* Forget what's on screen so the next RackDraw() draws every tile */
+void RackInvalidate(rackType *r)
+{
+  r->valid = false;
+}
+
+
+
+/* Clear the rack from the screen */
+void RackErase(rackType *r)
+{
+  RectangleType e;
+
+  /* Clear a big rectangle of full screen width by tile height.  Not
+     pretty but it works. */
+  e.topLeft.x = 0;
+  e.topLeft.y = YOFFSET;
+  e.extent.x = 159;
+  e.extent.y = TILEHEIGHT;
+  WinEraseRectangle(&e, 0);
+
+  r->valid = false;
+}
+
+
+
+/* Show letters in the rack with tile highlight (or -1) highlighted,
+   drawing only the tiles that differ from what's on screen */
+void RackDraw(rackType *r, const Char *letters, Int16 highlight)
+{
+  UInt16 len = StrLen(letters);
+  Boolean lit;
+  UInt16 i;
+
+  if (len > MAXWORDLENGTH)
+    len = MAXWORDLENGTH;
+
+  if (!r->valid || len != r->len)
+    {
+      /* Start again - a rack of a different length is in a different
+	 place */
+      RackErase(r);
+      RackLayout(r, len);
+    }
+
+  for (i = 0; i < len; i++)
+    {
+      lit = (i == highlight);
+      if (!r->valid || r->drawn[i] != letters[i] || r->lit[i] != lit)
+	{
+	  RackTile(r, i, letters[i], lit);
+	  r->drawn[i] = letters[i];
+	  r->lit[i] = lit;
+	}
+    }
+
+  r->valid = true;
+}
+
+
+
+/* The tile at screen position x, or -1 if there isn't one */
+Int16 RackHit(const rackType *r, Coord x)
+{
+  UInt16 i;
+
+  for (i = 0; i < r->len; i++)
+    if (x > r->tile[i].topLeft.x && x < r->tile[i].topLeft.x + r->tile[i].extent.x)
+      return i;
+
+  return -1;
+}
@@ -0,0 +1,45 @@
+/* The flashcard rack - the letters of the flashcard drawn as tiles.
+
+   The rack remembers what it last drew in each slot and only repaints
+   the slots whose letter or highlight have changed, so moving a tile
+   or reshuffling the rack touches as few tiles as it can.  Tiles are
+   drawn once per letter and highlight into an offscreen window and
+   copied from there, rather than being drawn up from a rectangle and a
+   font each time. */
+
+#ifndef RACK_H
+#define RACK_H
+
+#include "card.h"
+
+/* Tile and rack dimensions and positions */
+#define YOFFSET             22
+#define TILEWIDTH           16
+#define TILEHEIGHT          17
+#define TILESPACE            2
+
+/* Letters with a tile in the glyph cache, and the blank ('?') */
+#define RACKGLYPHS          27
+
+/* rackType - The tiles on screen and the glyph cache */
+typedef struct
+{
+  UInt16        len;                        /* Tiles in the rack */
+  Boolean       valid;                      /* Do drawn and lit match the screen? */
+  Char          drawn[MAXWORDLENGTH];       /* Letter drawn in each slot */
+  Boolean       lit[MAXWORDLENGTH];         /* ... and whether it was highlighted */
+  RectangleType tile[MAXWORDLENGTH];        /* Where each slot is */
+
+  WinHandle     glyphs;                     /* Tiles for each letter, plain and lit */
+  UInt32        ready[2];                   /* Tiles drawn into glyphs so far */
+  Boolean       noglyphs;                   /* No memory for glyphs - draw directly */
+} rackType;
+
+void    RackInit(rackType *r);
+void    RackFree(rackType *r);
+void    RackInvalidate(rackType *r);
+void    RackDraw(rackType *r, const Char *letters, Int16 highlight);
+Int16   RackHit(const rackType *r, Coord x);
+void    RackErase(rackType *r);
+
+#endif
@@ -0,0 +1,112 @@
+/* -----------------------------------------------------------------------------
+   Random number generator for LAMPFlash.
+
+   The generator is xoshiro128** (Blackman and Vigna) which has 128 bits
+   of state.  Drawing a number uses only shifts, rotates and adds - the
+   two multiplies by small constants are written out as shifts since
+   the 68000 has no 32-bit multiply.  Only seeding, which is done once,
+   multiplies.
+
+   Numbers in a range are drawn by masking to the next power of two and
+   rejecting anything out of range.  That needs no division and is
+   unbiased; on average fewer than two draws are needed.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "rand.h"
+
+
+#define ROTL(x, k)      (((x) << (k)) | ((x) >> (32 - (k))))
+
+
+/* Smallest mask of the form 2^k - 1 that covers n */
+static UInt32 RndMask(UInt32 n)
+{
+  n |= n >> 1;
+  n |= n >> 2;
+  n |= n >> 4;
+  n |= n >> 8;
+  n |= n >> 16;
+
+  return n;
+}
+
+
+
+/* Expand a 32-bit seed into the full state with splitmix32 so that
+   similar seeds give unrelated sequences.  The state can never end up
+   all zero. */
+void RndSeed(rngType *r, UInt32 seed)
+{
+  UInt16 i;
+  UInt32 z;
+
+  for (i = 0; i < 4; i++)
+    {
+      seed += 0x9E3779B9UL;
+      z = seed;
+      z = (z ^ (z >> 16)) * 0x85EBCA6BUL;
+      z = (z ^ (z >> 13)) * 0xC2B2AE35UL;
+      r->s[i] = z ^ (z >> 16);
+    }
+
+  if ((r->s[0] | r->s[1] | r->s[2] | r->s[3]) == 0)
+    r->s[0] = 1;
+}
+
+
+UInt32 RndNext(rngType *r)
+{
+  UInt32 x, t;
+
+  /* result = rotl(s1 * 5, 7) * 9 */
+  x = r->s[1] + (r->s[1] << 2);
+  x = ROTL(x, 7);
+  x = x + (x << 3);
+
+  t = r->s[1] << 9;
+  r->s[2] ^= r->s[0];
+  r->s[3] ^= r->s[1];
+  r->s[1] ^= r->s[2];
+  r->s[0] ^= r->s[3];
+  r->s[2] ^= t;
+  r->s[3] = ROTL(r->s[3], 11);
+
+  return x;
+}
+
+
+/* Random number in the range 0 to n - 1 */
+UInt32 RndBounded(rngType *r, UInt32 n)
+{
+  UInt32 mask, x;
+
+  if (n < 2)
+    return 0;
+
+  mask = RndMask(n - 1);
+  do
+    {
+      x = RndNext(r) & mask;
+    }
+  while (x >= n);
+
+  return x;
+}
+
+
+
+/* Fisher-Yates shuffle of a short string, such as the flashcard rack */
+void RndShuffleChars(rngType *r, Char *a, UInt16 n)
+{
+  UInt16 i, j;
+  Char t;
+
+  for (i = n; i > 1; i--)
+    {
+      j = RndBounded(r, i);
+      t = a[i - 1];
+      a[i - 1] = a[j];
+      a[j] = t;
+    }
+}
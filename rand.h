@@ -0,0 +1,23 @@
+/* Random number generator for LAMPFlash.
+
+   SysRandom() returns 15 bits at a time, shares its state with the rest
+   of the system and needs a divide to bring it into range, which is both
+   slow on the 68k and biased.  This is a small, seedable generator of our
+   own so that quizzes can be replayed from the seed they were dealt with. */
+
+#ifndef RAND_H
+#define RAND_H
+
+/* rngType - generator state (xoshiro128**) */
+typedef struct
+{
+  UInt32        s[4];
+} rngType;
+
+void    RndSeed(rngType *r, UInt32 seed);
+UInt32  RndNext(rngType *r);
+UInt32  RndBounded(rngType *r, UInt32 n);
+
+void    RndShuffleChars(rngType *r, Char *a, UInt16 n);
+
+#endif
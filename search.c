@@ -0,0 +1,172 @@
+/* -----------------------------------------------------------------------------
+   Pattern and anagram queries for LAMPFlash's dictionary.
+
+   Words in the dictionary are lowercase (see dictrec.h) so queries are
+   lowercased as they're parsed and compared byte for byte.
+   ----------------------------------------------------------------------------- */
+
+#include <PalmOS.h>
+#include "lf.h"
+#include "search.h"
+
+
+
+/* The length and letters of word */
+UInt32 SearchSignature(const Char *word, UInt16 len)
+{
+  UInt32 sig = 0;
+  UInt16 i;
+
+  for (i = 0; i < len; i++)
+    if (word[i] >= 'a' && word[i] <= 'z')
+      sig |= 1UL << (word[i] - 'a');
+
+  if (len > SIGLENGTHMAX)
+    len = SIGLENGTHMAX;
+
+  return sig | ((UInt32) len << SIGLENGTHSHIFT);
+}
+
+
+
+/* Parse text into q.  Returns the kind of query - SEARCHNONE for a
+   plain word, or anything else that isn't a pattern or an anagram. */
+UInt8 SearchParse(const Char *text, searchQueryType *q)
+{
+  Boolean wild = false;
+  Char c;
+
+  MemSet(q, sizeof(searchQueryType), 0);
+
+  while (*text == ' ')
+    text++;
+
+  q->kind = SEARCHPATTERN;
+  if (*text == SEARCHANAGRAMCHAR)
+    {
+      q->kind = SEARCHANAGRAM;
+      text++;
+    }
+
+  for (; *text && *text != ' '; text++)
+    {
+      if (q->textlen >= MAXDBTITLE)
+	return q->kind = SEARCHNONE;
+
+      c = *text;
+      if (c >= 'A' && c <= 'Z')
+	c += 'a' - 'A';
+
+      if (c >= 'a' && c <= 'z')
+	{
+	  q->minlen++;
+	  if (q->kind == SEARCHANAGRAM)
+	    q->rack |= 1UL << (c - 'a');
+	  else
+	    q->need |= 1UL << (c - 'a');
+	}
+      else if (c == '?')
+	{
+	  q->minlen++;
+	  q->blanks++;
+	  wild = true;
+	}
+      else if (c == '*' && q->kind == SEARCHPATTERN)
+	{
+	  /* Runs next to each other are the same as one */
+	  if (q->textlen && q->text[q->textlen - 1] == '*')
+	    continue;
+	  q->run = true;
+	  wild = true;
+	}
+      else
+	return q->kind = SEARCHNONE;
+
+      q->text[q->textlen++] = c;
+    }
+
+  /* A pattern with nothing wild in it is just a word to look up */
+  if (q->minlen == 0 || (q->kind == SEARCHPATTERN && !wild))
+    q->kind = SEARCHNONE;
+
+  /* A rack with more of a letter than a signature can count is too */
+  if (q->kind == SEARCHANAGRAM && AnagramSig(q->text, q->textlen, &q->sig) < 0)
+    q->kind = SEARCHNONE;
+
+  return q->kind;
+}
+
+
+
+/* Could the word with signature sig match q?  False means it can't. */
+Boolean SearchMaybe(const searchQueryType *q, UInt32 sig)
+{
+  UInt32 extra;
+  UInt16 len = SigLength(sig), n;
+
+  if (q->kind == SEARCHANAGRAM)
+    {
+      if (len != q->minlen)
+	return false;
+
+      /* Each letter not on the rack needs a blank */
+      extra = sig & SIGLETTERS & ~q->rack;
+      for (n = 0; extra; n++)
+	extra &= extra - 1;
+
+      return n <= q->blanks;
+    }
+
+  if (q->run ? len < q->minlen : len != q->minlen)
+    return false;
+
+  return (sig & q->need) == q->need;
+}
+
+
+
+/* Does the word (len bytes, not terminated) match q? */
+Boolean SearchMatch(const searchQueryType *q, const Char *word, UInt16 len)
+{
+  anagramSigType sig;
+  UInt16 p = 0, w = 0, star = 0, mark = 0;
+  Boolean starred = false;
+
+  if (q->kind == SEARCHANAGRAM)
+    {
+      /* Being as long as the rack, a word it holds uses every tile */
+      if (len != q->minlen || AnagramSig(word, len, &sig) != 0)
+	return false;
+
+      return AnagramHolds(&q->sig, &sig, q->blanks);
+    }
+
+  /* A '*' is tried against as little as it can be, and given one more
+     letter each time what follows it doesn't match */
+  while (w < len)
+    {
+      if (p < q->textlen && (q->text[p] == '?' || q->text[p] == word[w]))
+	{
+	  p++;
+	  w++;
+	}
+      else if (p < q->textlen && q->text[p] == '*')
+	{
+	  starred = true;
+	  star = ++p;
+	  mark = w;
+	}
+      else if (starred)
+	{
+	  p = star;
+	  w = ++mark;
+	}
+      else
+	return false;
+    }
+
+  while (p < q->textlen && q->text[p] == '*')
+    p++;
+
+  return p == q->textlen;
+}
@@ -0,0 +1,61 @@
+/* Pattern and anagram searches of the dictionary.
+
+   A query typed into the Dict form is one of
+
+       c?t*        a pattern - ? is any one letter, * any run of letters
+                   (none included)
+       =retains?   an anagram - words using exactly these tiles, where
+                   each ? is a blank
+
+   Anything else is an ordinary lookup.
+
+   Every headword has a signature - its length and a bit for each
+   letter it has - so most words can be turned down without being read:
+   a pattern's word has to be the right length and have every letter
+   the pattern spells out, and an anagram has to be exactly as long as
+   the rack with no more letters missing from the rack than there are
+   blanks.  Only words that get past that are matched properly (letter
+   count signatures - see anagram.h - for an anagram, the pattern itself
+   otherwise).
+
+   Nothing here touches the Data Manager - dict.c keeps the signatures
+   and walks the words. */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "anagram.h"
+
+#define SEARCHANAGRAMCHAR  '='
+
+/* Query kinds */
+#define SEARCHNONE          0  /* Not a search - look the word up */
+#define SEARCHPATTERN       1
+#define SEARCHANAGRAM       2
+
+/* A signature: a letter bit for a to z, and the length above them */
+#define SIGLETTERS         0x03FFFFFFUL
+#define SIGLENGTHSHIFT     26
+#define SIGLENGTHMAX       63
+#define SigLength(sig)     ((UInt16) ((sig) >> SIGLENGTHSHIFT))
+
+/* searchQueryType - A parsed query */
+typedef struct
+{
+  UInt8         kind;
+  Char          text[MAXDBTITLE + 1];  /* Lowercased, without the '=' */
+  UInt16        textlen;
+  UInt16        minlen;    /* Letters a match has at least (exactly without a '*') */
+  Boolean       run;       /* The pattern has a '*' */
+  UInt32        need;      /* Letters a pattern match must have */
+  UInt32        rack;      /* Letters on the anagram rack */
+  anagramSigType sig;      /* ... how many of each */
+  UInt8         blanks;
+} searchQueryType;
+
+UInt32  SearchSignature(const Char *word, UInt16 len);
+UInt8   SearchParse(const Char *text, searchQueryType *q);
+Boolean SearchMaybe(const searchQueryType *q, UInt32 sig);
+Boolean SearchMatch(const searchQueryType *q, const Char *word, UInt16 len);
+
+#endif
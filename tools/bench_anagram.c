@@ -0,0 +1,297 @@
+/* -----------------------------------------------------------------------------
+   bench_anagram - letter-count signatures against alphagram strings.
+
+   Each question is answered both ways over the same lexicon: with
+   alphagrams, as sorted strings compared with strcmp() the way the Palm
+   compares them with StrCompare(), and with the signatures of anagram.h
+   in the anagram index of deckbuild.h.
+
+     key     the alphagram or signature of every word
+     group   the words put into anagram groups (sorting the alphagrams,
+             or hashing the signatures)
+     find    the group of every word looked up
+     blank   the words a rack of seven tiles and one blank makes ("RETAIN?"),
+             and with two blanks, for random racks - every group of the
+             right length is tested against the rack (the index keeps
+             the groups in order of length)
+     build   the words of two to seven letters a rack of seven makes
+
+   Usage: bench_anagram [lexicon.txt]
+
+   Without a lexicon a made-up one of random words is used.  It has far
+   fewer anagrams than a real one, so the groups are smaller.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <PalmOS.h>
+#include "anagram.h"
+#include "deckbuild.h"
+#include "dictbuild.h"
+
+
+/* Words in the made-up lexicon, before repeats are dropped */
+#define MADEUP          280000
+
+/* Racks drawn for the blank and build-up tests */
+#define RACKS           2000
+
+#define RACKSIZE        7
+
+static const char bag[] =
+  "AAAAAAAAABBCCDDDDEEEEEEEEEEEEFFGGGHHIIIIIIIIIJKLLLLMMNNNNNN"
+  "OOOOOOOOPPQRRRRRRSSSSTTTTTTUUUUVVWWXYYZ";
+
+/* alphaType - A word's alphagram, for sorting into groups */
+typedef struct
+{
+  char          alpha[LEXWORDMAX + 1];
+  size_t        word;
+} alphaType;
+
+
+static volatile size_t sink;
+
+
+static int CompareAlpha(const void *a, const void *b)
+{
+  const alphaType *x = a, *y = b;
+  int c = strcmp(x->alpha, y->alpha);
+
+  return c ? c : (x->word > y->word) - (x->word < y->word);
+}
+
+
+
+static int CompareString(const void *a, const void *b)
+{
+  return strcmp(a, b);
+}
+
+
+
+/* Read a made-up lexicon into lex */
+static int MadeUp(lexType *lex)
+{
+  FILE *f = tmpfile();
+  size_t i, j, len;
+  int err;
+
+  if (!f)
+    {
+      perror("tmpfile");
+      return -1;
+    }
+
+  srand(1);
+  for (i = 0; i < MADEUP; i++)
+    {
+      len = 2 + rand() % 14;
+      for (j = 0; j < len; j++)
+	putc(bag[rand() % (sizeof(bag) - 1)], f);
+      putc('\n', f);
+    }
+
+  rewind(f);
+  err = LexRead(f, "made-up lexicon", lex);
+  fclose(f);
+
+  return err;
+}
+
+
+
+/* Can the alphagram be made from counts and blanks?  This is how it was
+   done before signatures - a letter at a time. */
+static int Holds(const unsigned char *counts, int blanks, const char *alpha)
+{
+  unsigned char left[26];
+
+  memcpy(left, counts, sizeof(left));
+  for (; *alpha; alpha++)
+    if (left[*alpha - 'A'])
+      left[*alpha - 'A']--;
+    else if (blanks-- == 0)
+      return 0;
+
+  return 1;
+}
+
+
+
+static void Report(const char *what, double strings, double sigs, size_t n)
+{
+  printf("  %-6s %9.1f ns %9.1f ns   x%.1f\n", what, 1e9 * strings / n, 1e9 * sigs / n,
+	 strings / sigs);
+}
+
+
+
+int main(int argc, char **argv)
+{
+  static lexType lex;
+  anagramIndexType idx;
+  alphaType *a;
+  char (*groupalpha)[LEXWORDMAX + 1], (*unique)[LEXWORDMAX + 1], rack[RACKSIZE + 1];
+  anagramSigType sig, racksig;
+  unsigned char counts[26];
+  size_t i, j, g, first, last, ngroups, len, found[2][3], alphabytes = 0;
+  UInt16 *grouplen;
+  double t, strings, sigs;
+  int r, blanks;
+  FILE *f;
+
+  if (argc > 1)
+    {
+      f = fopen(argv[1], "r");
+      if (!f)
+	{
+	  perror(argv[1]);
+	  return 1;
+	}
+      if (LexRead(f, argv[1], &lex) < 0)
+	return 1;
+      fclose(f);
+    }
+  else if (MadeUp(&lex) < 0)
+    return 1;
+
+  a = malloc(lex.n * sizeof(alphaType));
+  if (!a)
+    {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  printf("%zu words                alphagrams   signatures\n", lex.n);
+
+  /* key */
+  t = Now();
+  for (i = 0; i < lex.n; i++)
+    {
+      Alphagram(LexWord(&lex, i), strlen(LexWord(&lex, i)), a[i].alpha);
+      a[i].word = i;
+    }
+  strings = Now() - t;
+
+  t = Now();
+  for (i = 0; i < lex.n; i++)
+    {
+      AnagramSig(LexWord(&lex, i), strlen(LexWord(&lex, i)), &sig);
+      sink += sig.s[0] ^ sig.s[3];
+    }
+  sigs = Now() - t;
+  Report("key", strings, sigs, lex.n);
+
+  /* group */
+  t = Now();
+  qsort(a, lex.n, sizeof(alphaType), CompareAlpha);
+  unique = malloc(lex.n * sizeof(*unique));
+  for (i = 0, ngroups = 0; i < lex.n; i++)
+    if (i == 0 || strcmp(a[i].alpha, a[i - 1].alpha) != 0)
+      strcpy(unique[ngroups++], a[i].alpha);
+  strings = Now() - t;
+
+  t = Now();
+  if (AnagramIndexBuild(&lex, &idx) < 0)
+    return 1;
+  sigs = Now() - t;
+  Report("group", strings, sigs, lex.n);
+
+  if (idx.skipped == 0 && idx.n != ngroups)
+    printf("  %zu groups - but %zu from the alphagrams!\n", idx.n, ngroups);
+
+  /* find */
+  t = Now();
+  for (i = 0; i < lex.n; i++)
+    {
+      char alpha[LEXWORDMAX + 1];
+
+      Alphagram(LexWord(&lex, i), strlen(LexWord(&lex, i)), alpha);
+      sink += (char *) bsearch(alpha, unique, ngroups, sizeof(*unique), CompareString)
+	- (char *) unique;
+    }
+  strings = Now() - t;
+
+  t = Now();
+  for (i = 0; i < lex.n; i++)
+    {
+      AnagramSig(LexWord(&lex, i), strlen(LexWord(&lex, i)), &sig);
+      sink += AnagramIndexFind(&idx, &sig);
+    }
+  sigs = Now() - t;
+  Report("find", strings, sigs, lex.n);
+
+  /* The groups' alphagrams and lengths, made ahead so that only the
+     tests are timed */
+  groupalpha = malloc(idx.n * sizeof(*groupalpha));
+  grouplen = malloc(idx.n * sizeof(UInt16));
+  for (g = 0; g < idx.n; g++)
+    {
+      grouplen[g] = AnagramAlphagram(&idx.sig[g], groupalpha[g]);
+      alphabytes += grouplen[g] + 1;
+    }
+
+  /* blank and build */
+  for (blanks = 0; blanks <= 2; blanks++)
+    {
+      memset(found, 0, sizeof(found));
+      strings = sigs = 0;
+      srand(2);
+
+      for (r = 0; r < RACKS; r++)
+	{
+	  for (j = 0; j < RACKSIZE; j++)
+	    rack[j] = bag[rand() % (sizeof(bag) - 1)];
+	  rack[RACKSIZE] = '\0';
+
+	  memset(counts, 0, sizeof(counts));
+	  for (j = 0; j < RACKSIZE; j++)
+	    counts[rack[j] - 'A']++;
+	  AnagramSig(rack, RACKSIZE, &racksig);
+
+	  /* With blanks the words are as long as the rack, without them
+	     anything from two letters up to it */
+	  len = RACKSIZE + blanks;
+	  first = idx.bylen[blanks ? len : 2];
+	  last = idx.bylen[len + 1];
+
+	  t = Now();
+	  for (g = first; g < last; g++)
+	    found[0][blanks] += Holds(counts, blanks, groupalpha[g]);
+	  strings += Now() - t;
+
+	  t = Now();
+	  for (g = first; g < last; g++)
+	    found[1][blanks] += AnagramHolds(&racksig, &idx.sig[g], blanks);
+	  sigs += Now() - t;
+	}
+
+      if (found[0][blanks] != found[1][blanks])
+	printf("  %zu groups found - but %zu from the alphagrams!\n", found[1][blanks],
+	       found[0][blanks]);
+
+      Report(blanks == 0 ? "build" : blanks == 1 ? "blank" : "blank2", strings, sigs, RACKS);
+      printf("         (per rack, %.1f groups found of %zu)\n",
+	     (double) found[1][blanks] / RACKS, idx.n);
+    }
+
+  printf("  %zu groups, %zu bytes of alphagrams, %zu of signatures (%zu packed)\n", idx.n,
+	 alphabytes, idx.n * sizeof(anagramSigType), idx.n * (size_t) ANAGRAMPACKSIZE);
+  if (idx.skipped)
+    printf("  %zu words with more than %d of a letter have no signature\n", idx.skipped,
+	   ANAGRAMMAXCOUNT);
+
+  free(a);
+  free(unique);
+  free(groupalpha);
+  free(grouplen);
+  AnagramIndexFree(&idx);
+  LexFree(&lex);
+
+  /* Keep the compiler from throwing the work away */
+  if (sink == 0)
+    printf("\n");
+
+  return 0;
+}
@@ -0,0 +1,317 @@
+/* -----------------------------------------------------------------------------
+   bench_dict - size and lookup time of the plain and packed dictionary
+   layouts.
+
+   Both layouts are built from the same source with the same record
+   size, and looked up the way dict.c does it: the record from the
+   first-word index, the word from the record's key table, then the
+   definition made ready for display (escapes expanded for plain, the
+   definition unpacked for packed).
+
+     size    bytes in all the records
+     cold    a lookup that has to build the record's key table first -
+             the first lookup in a record
+     warm    a lookup with the table already kept
+     step    stepping to the next word and getting its definition
+
+   Usage: bench_dict [source.txt]
+
+   Without a source a made-up dictionary is used.  Its definitions are
+   drawn from a small vocabulary, so they pack rather better than real
+   ones will.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <PalmOS.h>
+#include "dictrec.h"
+#include "dictbuild.h"
+
+
+/* Lookups timed for each measurement */
+#define LOOKUPS         200000UL
+
+/* Words in the made-up dictionary, before repeats are dropped */
+#define MADEUP          80000
+
+
+/* A record's key table */
+typedef struct
+{
+  dictKeyType  *keys;
+  Char         *words;
+  const Char   *base;      /* What the keys' words are offsets into */
+  UInt16        count;
+} tableType;
+
+
+static const char *vocab[] = {
+  "a", "the", "of", "to", "in", "or", "and", "with", "for", "as", "by",
+  "plant", "tree", "fish", "bird", "animal", "small", "large", "kind",
+  "type", "person", "who", "which", "that", "is", "used", "made", "from",
+  "having", "being", "act", "state", "quality", "form", "of a", "pertaining to",
+  "resembling", "variant", "obsolete", "Scots", "dialect", "slang", "informal",
+  "[n -S]", "[v -ED, -ING, -S]", "[adj -ER, -EST]", "[n -ES]", "[adv]",
+  "cloth", "vessel", "instrument", "musical", "sea", "river", "colour",
+  "red", "green", "white", "black", "covering", "part", "body", "head",
+  "ancient", "coin", "weight", "measure", "unit", "game", "dance", "song",
+  NULL
+};
+
+
+
+static int CompareWords(const void *a, const void *b)
+{
+  return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+
+
+/* Fill src with a made-up dictionary */
+static void MadeUp(srcType *src)
+{
+  static char *words[MADEUP];
+  char def[512], *p;
+  size_t nvocab, i, j, n, len;
+
+  for (nvocab = 0; vocab[nvocab]; nvocab++)
+    ;
+
+  srand(1);
+  for (i = 0; i < MADEUP; i++)
+    {
+      len = 2 + rand() % 8;
+      words[i] = malloc(len + 1);
+      for (j = 0; j < len; j++)
+	words[i][j] = 'a' + rand() % 26;
+      words[i][len] = '\0';
+    }
+  qsort(words, MADEUP, sizeof(char *), CompareWords);
+
+  for (i = 0; i < MADEUP; i++)
+    {
+      if (i > 0 && strcmp(words[i], words[i - 1]) == 0)
+	continue;
+
+      p = def;
+      n = 3 + rand() % 18;
+      for (j = 0; j < n; j++)
+	{
+	  if (j > 0)
+	    p += sprintf(p, (rand() % 8 == 0) ? "\\n" : " ");
+	  p += sprintf(p, "%s", vocab[rand() % nvocab]);
+	}
+      SrcAdd(src, words[i], def);
+    }
+
+  for (i = 0; i < MADEUP; i++)
+    free(words[i]);
+}
+
+
+
+static void TableBuild(const recType *r, tableType *t)
+{
+  UInt16 wordsize;
+
+  t->count = DictRecScan(r->data, r->size, NULL, NULL, &wordsize);
+  t->keys = malloc((t->count + 1) * sizeof(dictKeyType));
+  t->words = malloc(wordsize + 1);
+  DictRecScan(r->data, r->size, t->keys, t->words, NULL);
+  t->base = wordsize ? t->words : (const Char *) r->data;
+}
+
+
+
+static void TableFree(tableType *t)
+{
+  free(t->keys);
+  free(t->words);
+}
+
+
+
+/* The record word is in, from the first words of the records */
+static size_t FindRecord(char **first, size_t n, const char *word)
+{
+  size_t lo = 0, hi = n, mid;
+
+  while (hi - lo > 1)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (strcmp(first[mid], word) <= 0)
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  return lo;
+}
+
+
+
+/* The first entry of t that doesn't sort before word */
+static UInt16 FindEntry(const tableType *t, const char *word)
+{
+  UInt16 lo = 0, hi = t->count, mid;
+
+  while (lo < hi)
+    {
+      mid = lo + (hi - lo) / 2;
+      if (DictRecCompare(word, t->base + t->keys[mid].word, t->keys[mid].wordlen) > 0)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  return lo;
+}
+
+
+
+/* Get the definition of entry e of t ready to show.  Returns its length. */
+static size_t Definition(const recType *r, const tableType *t, UInt16 e, char *out)
+{
+  const dictKeyType *k = &t->keys[e];
+  const char *s, *end;
+  char *d = out;
+
+  if (DictRecIsPacked(r->data, r->size))
+    return DictRecUnpack(r->data, k, out);
+
+  s = (const char *) r->data + k->def;
+  end = s + k->deflen;
+  while (s < end)
+    {
+      if (s[0] == '\\' && s + 1 < end && s[1] == 'n')
+	{
+	  *d++ = '\n';
+	  s += 2;
+	}
+      else
+	*d++ = *s++;
+    }
+
+  return d - out;
+}
+
+
+
+static void Bench(const char *name, const srcType *src, const imageType *img)
+{
+  static char out[0x10000];
+  char **first = malloc(img->n * sizeof(char *));
+  tableType *tables = malloc(img->n * sizeof(tableType));
+  tableType t;
+  size_t i, rec, sink = 0;
+  UInt16 e;
+  double start, secs;
+
+  for (i = 0; i < img->n; i++)
+    {
+      first[i] = malloc(DICTWORDMAX + 1);
+      DictRecFirstWord(img->rec[i].data, img->rec[i].size, first[i], DICTWORDMAX);
+      TableBuild(&img->rec[i], &tables[i]);
+    }
+
+  printf("  %-7s %9zu bytes %6zu records", name, img->bytes, img->n);
+
+  srand(2);
+  start = Now();
+  for (i = 0; i < LOOKUPS; i++)
+    {
+      const char *word = src->e[rand() % src->n].word;
+
+      rec = FindRecord(first, img->n, word);
+      TableBuild(&img->rec[rec], &t);
+      e = FindEntry(&t, word);
+      if (e < t.count)
+	sink += Definition(&img->rec[rec], &t, e, out);
+      TableFree(&t);
+    }
+  secs = Now() - start;
+  printf(" %8.2f us cold", secs * 1e6 / LOOKUPS);
+
+  srand(2);
+  start = Now();
+  for (i = 0; i < LOOKUPS; i++)
+    {
+      const char *word = src->e[rand() % src->n].word;
+
+      rec = FindRecord(first, img->n, word);
+      e = FindEntry(&tables[rec], word);
+      if (e < tables[rec].count)
+	sink += Definition(&img->rec[rec], &tables[rec], e, out);
+    }
+  secs = Now() - start;
+  printf(" %8.3f us warm", secs * 1e6 / LOOKUPS);
+
+  start = Now();
+  for (i = 0, rec = 0, e = 0; i < LOOKUPS; i++)
+    {
+      sink += Definition(&img->rec[rec], &tables[rec], e, out);
+      if (++e >= tables[rec].count)
+	{
+	  e = 0;
+	  rec = (rec + 1) % img->n;
+	}
+    }
+  secs = Now() - start;
+  printf(" %8.3f us step\n", secs * 1e6 / LOOKUPS);
+
+  for (i = 0; i < img->n; i++)
+    {
+      free(first[i]);
+      TableFree(&tables[i]);
+    }
+  free(first);
+  free(tables);
+
+  /* Keep the compiler from throwing the work away */
+  if (sink == 0)
+    printf("\n");
+}
+
+
+
+int main(int argc, char **argv)
+{
+  srcType src = { 0 };
+  imageType plain, packed;
+  size_t raw = 0, i;
+  FILE *f;
+
+  if (argc > 1)
+    {
+      f = fopen(argv[1], "r");
+      if (!f)
+	{
+	  perror(argv[1]);
+	  return 1;
+	}
+      if (SrcRead(f, argv[1], &src) < 0 || SrcCheck(&src) < 0)
+	return 1;
+      fclose(f);
+    }
+  else
+    MadeUp(&src);
+
+  for (i = 0; i < src.n; i++)
+    raw += strlen(src.e[i].word) + strlen(src.e[i].def) + 2;
+
+  if (ImageBuild(&src, 0, DICTRECSIZE, &plain) < 0
+      || ImageBuild(&src, 1, DICTRECSIZE, &packed) < 0)
+    return 1;
+
+  printf("%zu words, %zu bytes of entries, %d bytes a record\n", src.n, raw, DICTRECSIZE);
+  Bench("plain", &src, &plain);
+  Bench("packed", &src, &packed);
+  printf("  packed is %.1f%% of plain\n", 100.0 * packed.bytes / plain.bytes);
+
+  ImageFree(&plain);
+  ImageFree(&packed);
+  SrcFree(&src);
+
+  return 0;
+}
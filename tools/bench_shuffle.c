@@ -0,0 +1,112 @@
+/* -----------------------------------------------------------------------------
+   bench_shuffle - shuffle throughput of the LAMPFlash random number code.
+
+   Times, for decks of 250, 10k and 65535 (the most a DB holds) cards:
+
+     sysrandom   the old swap loop - two 15-bit SysRandom()-style draws
+                 combined and brought into range with a modulo
+     deal        QuizUnhideAll() alone - what opening a deck now costs
+     deal+draw   QuizUnhideAll() and then drawing every card of the deal
+
+   Usage: bench_shuffle [seed]
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <PalmOS.h>
+#include "rand.h"
+#include "quiz.h"
+#include "dictbuild.h"
+
+
+/* Roughly this many cards are shuffled for each measurement */
+#define WORK            4000000UL
+
+
+static UInt32 lcg;
+
+/* A 15-bit linear congruential generator standing in for SysRandom() */
+static UInt32 SysRandom15(void)
+{
+  lcg = lcg * 1103515245UL + 12345;
+  return (lcg >> 16) & 0x7FFF;
+}
+
+
+static void Report(const char *name, UInt32 n, UInt32 reps, double secs)
+{
+  double cards = (double) n * reps;
+
+  printf("  %-11s %10.2f ns/card %10.2f Mcards/s\n", name,
+	 secs * 1e9 / cards, cards / secs / 1e6);
+}
+
+
+
+static void Bench(UInt32 n, UInt32 seed)
+{
+  UInt32 *a = malloc(n * sizeof(UInt32));
+  UInt32 reps = (WORK / n) ? WORK / n : 1;
+  UInt32 i, k, r, t, sink = 0;
+  quizType q;
+  double start;
+
+  printf("%lu cards (%lu runs)\n", (unsigned long) n, (unsigned long) reps);
+
+  for (i = 0; i < n; i++)
+    a[i] = i;
+
+  /* The old way */
+  lcg = seed;
+  start = Now();
+  for (k = 0; k < reps; k++)
+    for (i = n - 1; i > 0; i--)
+      {
+	r = ((SysRandom15() << 15) | SysRandom15()) % (i + 1);
+	t = a[i];
+	a[i] = a[r];
+	a[r] = t;
+      }
+  Report("sysrandom", n, reps, Now() - start);
+  sink += a[0];
+
+  if (QuizInit(&q, n) != errNone)
+    {
+      printf("  out of memory\n");
+      free(a);
+      return;
+    }
+
+  start = Now();
+  for (k = 0; k < reps; k++)
+    sink += QuizUnhideAll(&q, seed + k);
+  Report("deal", n, reps, Now() - start);
+
+  start = Now();
+  for (k = 0; k < reps; k++)
+    {
+      QuizUnhideAll(&q, seed + k);
+      for (i = 0; i < n; i++)
+	sink += QuizCard(&q, i);
+    }
+  Report("deal+draw", n, reps, Now() - start);
+
+  QuizFree(&q);
+  free(a);
+
+  /* Keep the compiler from throwing the work away */
+  if (sink == 0xFFFFFFFFUL)
+    printf("\n");
+}
+
+
+
+int main(int argc, char **argv)
+{
+  UInt32 seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 12345;
+
+  Bench(250, seed);
+  Bench(10000, seed);
+  Bench(65535, seed);
+
+  return 0;
+}
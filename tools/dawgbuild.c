@@ -0,0 +1,245 @@
+/* -----------------------------------------------------------------------------
+   Building minimal DAWGs for the lexicon.
+
+   The nodes still being built are the ones along the last string added,
+   one per letter.  All but the last edge of each lead to finished nodes;
+   the last leads to the next node along.  A node is finished by writing
+   its edges out - unless the same edges have been written already, in
+   which case that node is used instead.  Finished nodes are found by a
+   hash of their edges.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <PalmOS.h>
+#include "dawg.h"
+#include "dawgbuild.h"
+
+/* Longest string - a GADDAG has the separator as well as the word */
+#define STRMAX          (DAWGWORDMAX + 1)
+
+/* Letters a node can have edges for */
+#define NODEMAX         DAWGSEPARATOR
+
+/* Edges can only lead as far as this */
+#define EDGESMAX        (1UL << 25)
+
+/* pathType - A node still being built */
+typedef struct
+{
+  int           n;
+  uint8_t       letter[NODEMAX];
+  uint8_t       end[NODEMAX];
+  uint32_t      child[NODEMAX];
+  int           final;     /* A string ends here */
+} pathType;
+
+
+
+static uint32_t EdgeWord(const pathType *p, int i)
+{
+  return p->letter[i] | (p->end[i] ? 0x20 : 0) | (i == p->n - 1 ? 0x40 : 0)
+    | (p->child[i] << 7);
+}
+
+
+
+static size_t HashEdges(const uint32_t *e, int n)
+{
+  size_t h = 2166136261u;
+  int i;
+
+  for (i = 0; i < n; i++)
+    h = (h ^ e[i]) * 16777619u;
+
+  return h;
+}
+
+
+
+/* Edges in the node written at first */
+static int NodeSize(const dawgBuildType *b, size_t first)
+{
+  int n = 1;
+
+  while (!(b->edge[first + n - 1] & 0x40))
+    n++;
+
+  return n;
+}
+
+
+
+/* The slot of the node with these n edges, or the empty one it would go in */
+static size_t Slot(const dawgBuildType *b, const uint32_t *e, int n)
+{
+  size_t i = HashEdges(e, n) & (b->hashsize - 1), first;
+
+  while ((first = b->hash[i]) != 0)
+    {
+      if (first + n <= b->n && memcmp(b->edge + first, e, n * sizeof(uint32_t)) == 0)
+	break;
+      i = (i + 1) & (b->hashsize - 1);
+    }
+
+  return i;
+}
+
+
+
+static int Rehash(dawgBuildType *b)
+{
+  size_t *old = b->hash, oldsize = b->hashsize, i;
+
+  b->hashsize = oldsize ? 2 * oldsize : 1 << 16;
+  b->hash = calloc(b->hashsize, sizeof(size_t));
+  if (!b->hash)
+    return -1;
+
+  for (i = 0; i < oldsize; i++)
+    if (old[i])
+      b->hash[Slot(b, b->edge + old[i], NodeSize(b, old[i]))] = old[i];
+
+  free(old);
+  return 0;
+}
+
+
+
+/* Finish node p.  Returns its first edge - 0 if it has none - or -1. */
+static long Finish(dawgBuildType *b, const pathType *p)
+{
+  uint32_t e[NODEMAX];
+  size_t slot;
+  int i;
+
+  if (p->n == 0)
+    return 0;
+
+  for (i = 0; i < p->n; i++)
+    e[i] = EdgeWord(p, i);
+
+  slot = Slot(b, e, p->n);
+  if (b->hash[slot])
+    return b->hash[slot];
+
+  if (b->n + p->n >= EDGESMAX)
+    {
+      fprintf(stderr, "too many edges for the lexicon\n");
+      return -1;
+    }
+
+  while (b->n + p->n > b->cap)
+    {
+      b->cap = b->cap ? 2 * b->cap : 1 << 16;
+      b->edge = realloc(b->edge, b->cap * sizeof(uint32_t));
+      if (!b->edge)
+	return -1;
+    }
+
+  /* Edge 0 is never used, but it is written out with the rest */
+  if (b->n == 1)
+    b->edge[0] = 0;
+
+  memcpy(b->edge + b->n, e, p->n * sizeof(uint32_t));
+  b->hash[slot] = b->n;
+  b->n += p->n;
+  b->nodes++;
+
+  if (2 * b->nodes > b->hashsize && Rehash(b) < 0)
+    return -1;
+
+  return b->hash[Slot(b, e, p->n)];
+}
+
+
+
+/* Finish the nodes along the path deeper than depth, from the bottom */
+static int FinishPath(dawgBuildType *b, pathType *path, int from, int depth)
+{
+  pathType *p;
+  long first;
+  int d;
+
+  for (d = from; d > depth; d--)
+    {
+      if ((first = Finish(b, &path[d])) < 0)
+	return -1;
+
+      p = &path[d - 1];
+      p->child[p->n - 1] = first;
+      p->end[p->n - 1] = path[d].final;
+    }
+
+  return 0;
+}
+
+
+
+void DawgBuildInit(dawgBuildType *b)
+{
+  memset(b, 0, sizeof(dawgBuildType));
+  b->n = 1;
+}
+
+
+
+/* Add the graph of the n strings s (sorted) to b.  Sets root to the
+   first edge of its root, and returns 0, or -1. */
+int DawgBuildAdd(dawgBuildType *b, char **s, size_t n, uint32_t *root)
+{
+  static pathType path[STRMAX + 1];
+  const char *prev = "";
+  size_t i, len, c, d, plen = 0;
+  long first;
+
+  if (!b->hash && Rehash(b) < 0)
+    return -1;
+
+  memset(&path[0], 0, sizeof(pathType));
+
+  for (i = 0; i < n; i++)
+    {
+      len = strlen(s[i]);
+      if (len == 0 || len > STRMAX)
+	continue;
+
+      for (c = 0; c < len && c < plen && s[i][c] == prev[c]; c++)
+	;
+      if (c == len)
+	continue;          /* A repeat */
+
+      if (FinishPath(b, path, plen, c) < 0)
+	return -1;
+
+      for (d = c; d < len; d++)
+	{
+	  path[d].letter[path[d].n] = s[i][d];
+	  path[d].end[path[d].n] = 0;
+	  path[d].child[path[d].n] = 0;
+	  path[d].n++;
+	  path[d + 1].n = 0;
+	  path[d + 1].final = 0;
+	}
+      path[len].final = 1;
+
+      prev = s[i];
+      plen = len;
+    }
+
+  if (FinishPath(b, path, plen, 0) < 0 || (first = Finish(b, &path[0])) < 0)
+    return -1;
+
+  *root = first;
+  return 0;
+}
+
+
+
+void DawgBuildFree(dawgBuildType *b)
+{
+  free(b->edge);
+  free(b->hash);
+  memset(b, 0, sizeof(dawgBuildType));
+}
@@ -0,0 +1,33 @@
+/* Building the lexicon's DAWG and GADDAG (see dawg.h) on the host.
+
+   Strings go in sorted, as letter codes (1 to 26, and DAWGSEPARATOR)
+   ended by a 0, and come out as the edges of the smallest graph that
+   spells them: the trie is built along the sorted strings, and each
+   node is finished as soon as no later string can reach it and then
+   swapped for the same node already made, if there is one (Daciuk et
+   al.'s incremental construction).  Finished nodes are written out as
+   they are made, so the trie is never held whole.
+
+   The DAWG and the GADDAG go into one set of edges, and share any
+   nodes they can. */
+
+#ifndef DAWGBUILD_H
+#define DAWGBUILD_H
+
+#include <stdint.h>
+
+/* dawgBuildType - The edges so far, and the nodes made */
+typedef struct
+{
+  uint32_t     *edge;      /* Edge 0 isn't used - 0 means no node */
+  size_t        n, cap;
+  size_t       *hash;      /* First edge of a node, or 0 if empty */
+  size_t        hashsize;
+  size_t        nodes;
+} dawgBuildType;
+
+void  DawgBuildInit(dawgBuildType *b);
+int   DawgBuildAdd(dawgBuildType *b, char **s, size_t n, uint32_t *root);
+void  DawgBuildFree(dawgBuildType *b);
+
+#endif
@@ -0,0 +1,433 @@
+/* -----------------------------------------------------------------------------
+   Lexicons and flashcard records for the host tools.
+
+   The lexicon's hash is filled as words are read, which is also how
+   repeated words are found.  Once it's read nothing changes it, so any
+   number of threads can look words up at the same time.  The same goes
+   for the anagram index.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <PalmOS.h>
+#include "lf.h"
+#include "card.h"
+#include "anagram.h"
+#include "dictbuild.h"
+#include "deckbuild.h"
+
+
+
+static void *Grow(void *p, size_t *cap, size_t n, size_t size)
+{
+  if (n < *cap)
+    return p;
+
+  *cap = *cap ? 2 * *cap : 1024;
+  p = realloc(p, *cap * size);
+  if (!p)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+
+  return p;
+}
+
+
+
+/* Hooks as the letters of a text record, lowercase as the Palm shows
+   them */
+static size_t HookString(uint32_t hooks, char *s)
+{
+  char *p = s, c = 'a';
+
+  for (; hooks; hooks >>= 1, c++)
+    if (hooks & 1)
+      *p++ = c;
+
+  return p - s;
+}
+
+
+
+/* FNV-1a */
+static size_t Hash(const char *s, size_t len)
+{
+  size_t h = 2166136261u, i;
+
+  for (i = 0; i < len; i++)
+    h = (h ^ (unsigned char) s[i]) * 16777619u;
+
+  return h;
+}
+
+
+
+/* The hash slot of s, or the empty slot it would go in */
+static size_t LexSlot(const lexType *lex, const char *s, size_t len)
+{
+  size_t i = Hash(s, len) & (lex->hashsize - 1), w;
+
+  while ((w = lex->hash[i]) != 0)
+    {
+      const char *t = LexWord(lex, w - 1);
+
+      if (strncmp(t, s, len) == 0 && t[len] == '\0')
+	break;
+      i = (i + 1) & (lex->hashsize - 1);
+    }
+
+  return i;
+}
+
+
+
+/* Double the hash table and put every word back in */
+static void LexRehash(lexType *lex)
+{
+  size_t i;
+
+  free(lex->hash);
+  lex->hashsize = lex->hashsize ? 2 * lex->hashsize : 1 << 16;
+  lex->hash = calloc(lex->hashsize, sizeof(size_t));
+  if (!lex->hash)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+
+  for (i = 0; i < lex->n; i++)
+    lex->hash[LexSlot(lex, LexWord(lex, i), strlen(LexWord(lex, i)))] = i + 1;
+}
+
+
+
+/* Read the word list f (called name in messages) into lex */
+int LexRead(FILE *f, const char *name, lexType *lex)
+{
+  char *line = NULL, *s;
+  size_t linecap = 0, len, slot;
+
+  memset(lex, 0, sizeof(lexType));
+  LexRehash(lex);
+
+  while (getline(&line, &linecap, f) >= 0)
+    {
+      for (s = line; *s == ' ' || *s == '\t'; s++)
+	;
+      for (len = 0; isalpha((unsigned char) s[len]); len++)
+	s[len] = toupper((unsigned char) s[len]);
+
+      if (len == 0 || len > LEXWORDMAX)
+	{
+	  lex->skipped++;
+	  continue;
+	}
+
+      /* Keep the hash no more than half full */
+      if (2 * (lex->n + 1) > lex->hashsize)
+	LexRehash(lex);
+
+      while (lex->size + len + 1 > lex->cap)
+	lex->text = Grow(lex->text, &lex->cap, lex->cap, 1);
+      memcpy(lex->text + lex->size, s, len);
+      lex->text[lex->size + len] = '\0';
+
+      slot = LexSlot(lex, lex->text + lex->size, len);
+      if (lex->hash[slot])
+	{
+	  lex->repeats++;
+	  continue;
+	}
+
+      lex->word = Grow(lex->word, &lex->wcap, lex->n, sizeof(size_t));
+      lex->word[lex->n] = lex->size;
+      lex->hash[slot] = ++lex->n;
+      lex->size += len + 1;
+    }
+
+  free(line);
+
+  if (ferror(f))
+    {
+      perror(name);
+      return -1;
+    }
+
+  return 0;
+}
+
+
+
+/* Is the len bytes of s a word of lex? */
+int LexHas(const lexType *lex, const char *s, size_t len)
+{
+  return lex->hash[LexSlot(lex, s, len)] != 0;
+}
+
+
+
+/* The letters that can go on the front and back of word to make
+   another word of lex */
+void LexHooks(const lexType *lex, const char *word, size_t len,
+	      uint32_t *front, uint32_t *back)
+{
+  char buf[LEXWORDMAX + 2];
+  char c;
+
+  *front = *back = 0;
+  if (len + 1 > LEXWORDMAX)
+    return;
+
+  memcpy(buf + 1, word, len);
+  for (c = 'A'; c <= 'Z'; c++)
+    {
+      buf[0] = c;
+      if (LexHas(lex, buf, len + 1))
+	*front |= HOOKBIT(c);
+
+      buf[len + 1] = c;
+      if (LexHas(lex, buf + 1, len + 1))
+	*back |= HOOKBIT(c);
+    }
+}
+
+
+
+void LexFree(lexType *lex)
+{
+  free(lex->text);
+  free(lex->word);
+  free(lex->hash);
+  memset(lex, 0, sizeof(lexType));
+}
+
+
+
+static size_t IndexSlot(const anagramIndexType *idx, const anagramSigType *sig)
+{
+  size_t i = AnagramHash(sig) & (idx->hashsize - 1), g;
+
+  while ((g = idx->hash[i]) != 0 && !AnagramEqual(&idx->sig[g - 1], sig))
+    i = (i + 1) & (idx->hashsize - 1);
+
+  return i;
+}
+
+
+
+/* Group the words of lex by signature.  Groups are in order of length
+   and then of their first words, and words are in lexicon order within
+   a group. */
+int AnagramIndexBuild(const lexType *lex, anagramIndexType *idx)
+{
+  size_t *group, *order, at[LEXWORDMAX + 2], i, g, slot, len;
+  anagramSigType sig, *sigs;
+
+  memset(idx, 0, sizeof(anagramIndexType));
+  for (idx->hashsize = 1024; idx->hashsize < 2 * lex->n; idx->hashsize *= 2)
+    ;
+
+  idx->hash = calloc(idx->hashsize, sizeof(size_t));
+  idx->sig = malloc((lex->n + 1) * sizeof(anagramSigType));
+  idx->first = calloc(lex->n + 2, sizeof(size_t));
+  idx->word = malloc((lex->n + 1) * sizeof(size_t));
+  group = malloc((lex->n + 1) * sizeof(size_t));
+  order = malloc((lex->n + 1) * sizeof(size_t));
+  sigs = malloc((lex->n + 1) * sizeof(anagramSigType));
+  if (!idx->hash || !idx->sig || !idx->first || !idx->word || !group || !order || !sigs)
+    {
+      fprintf(stderr, "out of memory\n");
+      free(group);
+      free(order);
+      free(sigs);
+      AnagramIndexFree(idx);
+      return -1;
+    }
+
+  /* Find each word's group, numbering the groups as they're found */
+  for (i = 0; i < lex->n; i++)
+    {
+      if (AnagramSig(LexWord(lex, i), strlen(LexWord(lex, i)), &sig) != 0)
+	{
+	  group[i] = (size_t) -1;
+	  idx->skipped++;
+	  continue;
+	}
+
+      slot = IndexSlot(idx, &sig);
+      if (!idx->hash[slot])
+	{
+	  idx->sig[idx->n] = sig;
+	  idx->hash[slot] = ++idx->n;
+	}
+      group[i] = idx->hash[slot] - 1;
+    }
+
+  /* Renumber them by length */
+  memcpy(sigs, idx->sig, idx->n * sizeof(anagramSigType));
+  for (g = 0; g < idx->n; g++)
+    idx->bylen[AnagramLength(&sigs[g]) + 1]++;
+  for (len = 1; len <= LEXWORDMAX + 1; len++)
+    idx->bylen[len] += idx->bylen[len - 1];
+  memcpy(at, idx->bylen, sizeof(at));
+
+  for (g = 0; g < idx->n; g++)
+    {
+      order[g] = at[AnagramLength(&sigs[g])]++;
+      idx->sig[order[g]] = sigs[g];
+    }
+  for (slot = 0; slot < idx->hashsize; slot++)
+    if (idx->hash[slot])
+      idx->hash[slot] = order[idx->hash[slot] - 1] + 1;
+
+  /* Count the words in each group, one place up so that adding them up
+     leaves the start of each group */
+  for (i = 0; i < lex->n; i++)
+    if (group[i] != (size_t) -1)
+      {
+	group[i] = order[group[i]];
+	idx->first[group[i] + 2]++;
+      }
+
+  for (g = 2; g <= idx->n + 1; g++)
+    idx->first[g] += idx->first[g - 1];
+
+  for (i = 0; i < lex->n; i++)
+    if (group[i] != (size_t) -1)
+      idx->word[idx->first[group[i] + 1]++] = i;
+  idx->words = idx->first[idx->n];
+
+  free(group);
+  free(order);
+  free(sigs);
+  return 0;
+}
+
+
+
+/* The group of the words with signature sig, or -1 if there are none */
+long AnagramIndexFind(const anagramIndexType *idx, const anagramSigType *sig)
+{
+  return (long) idx->hash[IndexSlot(idx, sig)] - 1;
+}
+
+
+
+void AnagramIndexFree(anagramIndexType *idx)
+{
+  free(idx->sig);
+  free(idx->first);
+  free(idx->word);
+  free(idx->hash);
+  memset(idx, 0, sizeof(anagramIndexType));
+}
+
+
+
+/* The letters of word (uppercase) in alphabetical order, in out */
+void Alphagram(const char *word, size_t len, char *out)
+{
+  size_t count[26] = { 0 }, i, j;
+
+  for (i = 0; i < len; i++)
+    count[(word[i] & 0x1F) - 1]++;
+
+  for (i = 0; i < 26; i++)
+    for (j = 0; j < count[i]; j++)
+      *out++ = 'A' + i;
+  *out = '\0';
+}
+
+
+
+/* A binary card record (card.h) asking question with the n answers a.
+   Returns it, malloc()ed, or NULL if it would be over 64K. */
+unsigned char *CardBinary(const char *question, const deckAnswerType *a,
+			  size_t n, size_t *size)
+{
+  unsigned char *rec, *p;
+  size_t i, off;
+
+  *size = 8 + 12 * n + strlen(question) + 1;
+  for (i = 0; i < n; i++)
+    *size += strlen(a[i].word) + 1;
+
+  if (*size > 0xFFFF)
+    return NULL;
+
+  rec = calloc(*size, 1);
+  if (!rec)
+    return NULL;
+
+  rec[0] = CARDMAGIC;
+  rec[1] = CARDVERSION;
+  Put16(rec + 2, n);
+  Put16(rec + 4, *size);
+
+  off = 8 + 12 * n;
+  Put16(rec + 6, off);
+  strcpy((char *) rec + off, question);
+  off += strlen(question) + 1;
+
+  for (i = 0, p = rec + 8; i < n; i++, p += 12)
+    {
+      Put16(p, off);
+      Put16(p + 2, a[i].blank);
+      Put32(p + 4, a[i].front);
+      Put32(p + 8, a[i].back);
+      strcpy((char *) rec + off, a[i].word);
+      off += strlen(a[i].word) + 1;
+    }
+
+  return rec;
+}
+
+
+
+/* A text card record, as the Palm has always read them - with each
+   answer's hooks if hooks is set.  The letter a blank stands for is
+   written in lowercase - the last of that letter in the word. */
+unsigned char *CardText(const char *question, const deckAnswerType *a,
+			size_t n, int hooks, size_t *size)
+{
+  char *rec, *p, *b;
+  size_t i;
+
+  /* An answer takes at most itself, 26 hooks each side and 3 '/'s */
+  rec = malloc(strlen(question) + 2 + n * (LEXWORDMAX + 2 * 26 + 4));
+  if (!rec)
+    return NULL;
+
+  p = rec + sprintf(rec, "%s\t", question);
+  for (i = 0; i < n; i++)
+    {
+      if (i > 0 && p[-1] != '/')
+	*p++ = ' ';
+      p += sprintf(p, "%s", a[i].word);
+      if (a[i].blank && (b = strrchr(p - strlen(a[i].word), a[i].blank)) != NULL)
+	*b += 'a' - 'A';
+
+      if (hooks && (a[i].front || a[i].back))
+	{
+	  *p++ = '/';
+	  p += HookString(a[i].front, p);
+	  *p++ = '/';
+	  p += HookString(a[i].back, p);
+	  *p++ = '/';
+	}
+    }
+  *p++ = '\0';
+
+  *size = p - rec;
+  if (*size > 0xFFFF)
+    {
+      free(rec);
+      return NULL;
+    }
+
+  return (unsigned char *) rec;
+}
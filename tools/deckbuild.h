@@ -0,0 +1,86 @@
+/* Building flashcard decks on the host.
+
+   A lexicon is read from a word list - the first word of each line,
+   uppercased, with anything that isn't a letter ending it - into one
+   block of text, and hashed so that whether a string is a word can be
+   asked from any number of threads at once.
+
+   The anagram index groups a lexicon's words by their letter-count
+   signatures (anagram.h) and hashes the groups, so a rack's anagrams are
+   one lookup away and every group can be tested against a rack without
+   touching its words.
+
+   Cards are written in either of the record formats of card.h: binary
+   (the default - it is read in place on the Palm) or text. */
+
+#ifndef DECKBUILD_H
+#define DECKBUILD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "anagram.h"
+
+/* Longest word kept in a lexicon - longer ones can't be hooks of a card
+   or on one */
+#define LEXWORDMAX        15
+
+/* Type of a flashcard DB */
+#define DECKDBTYPE        "DATA"
+#define DECKDBCREATOR     "shLF"
+
+/* lexType - The words of a lexicon */
+typedef struct
+{
+  char         *text;      /* Every word, each ended by a NULL */
+  size_t        size, cap;
+  size_t       *word;      /* Offsets of the words in text */
+  size_t        n, wcap;
+  size_t       *hash;      /* Open addressing - index + 1, or 0 if empty */
+  size_t        hashsize;  /* A power of two */
+  size_t        repeats;   /* Words dropped as already read */
+  size_t        skipped;   /* Lines with no word, or one too long */
+} lexType;
+
+/* anagramIndexType - The words of a lexicon grouped by signature */
+typedef struct
+{
+  anagramSigType *sig;     /* Of each group */
+  size_t       *first;     /* Group g is words first[g] to first[g + 1] - 1 ... */
+  size_t       *word;      /* ... of these lexicon word numbers */
+  size_t        n;         /* Groups */
+  size_t        bylen[LEXWORDMAX + 2];  /* Groups of length l are bylen[l] to bylen[l + 1] - 1 */
+  size_t        words;
+  size_t       *hash;      /* Group + 1, or 0 if empty */
+  size_t        hashsize;  /* A power of two */
+  size_t        skipped;   /* Words with too many of a letter to sign */
+} anagramIndexType;
+
+/* deckAnswerType - An answer of a card being written */
+typedef struct
+{
+  const char   *word;      /* Uppercase */
+  uint32_t      front;     /* Hooks as card.h has them */
+  uint32_t      back;
+  char          blank;     /* Letter a blank stands for, or 0 */
+} deckAnswerType;
+
+int   LexRead(FILE *f, const char *name, lexType *lex);
+int   LexHas(const lexType *lex, const char *s, size_t len);
+void  LexHooks(const lexType *lex, const char *word, size_t len,
+	       uint32_t *front, uint32_t *back);
+void  LexFree(lexType *lex);
+
+#define LexWord(lex, i)   ((lex)->text + (lex)->word[i])
+
+int   AnagramIndexBuild(const lexType *lex, anagramIndexType *idx);
+long  AnagramIndexFind(const anagramIndexType *idx, const anagramSigType *sig);
+void  AnagramIndexFree(anagramIndexType *idx);
+
+void  Alphagram(const char *word, size_t len, char *out);
+
+unsigned char *CardBinary(const char *question, const deckAnswerType *a,
+			  size_t n, size_t *size);
+unsigned char *CardText(const char *question, const deckAnswerType *a,
+			size_t n, int hooks, size_t *size);
+
+#endif
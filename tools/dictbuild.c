@@ -0,0 +1,659 @@
+/* -----------------------------------------------------------------------------
+   Building the dictionary on the host - reading the source, cutting it
+   into records and writing the PDB.
+
+   Packing a record pairs up bytes greedily: the pair of symbols seen
+   most often in the record's definitions gets the next free code and
+   every occurrence is replaced, until the codes run out or no pair
+   turns up often enough to pay for its two bytes in the table.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <PalmOS.h>
+#include "dictrec.h"
+#include "dictbuild.h"
+
+
+/* A pair has to save more than this to get a code */
+#define PAIRMIN           3
+
+/* The layout of dictIndexType in dict.h - a title, then the magic,
+   modification number, record count and key size */
+#define INDEXTITLE        32
+#define INDEXHEADER       (INDEXTITLE + 12)
+#define DICTINDEXMAGICSTR "LFDX"
+
+/* Seconds from 1904, when Palm time starts, to 1970 */
+#define PALMEPOCH         2082844800UL
+
+
+/* A definition being packed */
+typedef struct
+{
+  unsigned char *s;
+  size_t         len;
+  size_t         rawlen;
+} packDefType;
+
+
+
+static void *Grow(void *p, size_t *cap, size_t n, size_t size)
+{
+  if (n < *cap)
+    return p;
+
+  *cap = *cap ? 2 * *cap : 1024;
+  p = realloc(p, *cap * size);
+  if (!p)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+
+  return p;
+}
+
+
+
+int SrcAdd(srcType *src, const char *word, const char *def)
+{
+  src->e = Grow(src->e, &src->cap, src->n, sizeof(srcEntryType));
+  src->e[src->n].word = strdup(word);
+  src->e[src->n].def = strdup(def);
+  if (!src->e[src->n].word || !src->e[src->n].def)
+    return -1;
+
+  src->n++;
+  return 0;
+}
+
+
+
+/* Split a line of the source into its word and definition, line
+   numbered lineno of name for messages.  The newline is dropped and the
+   word is lowercased, as the words looked up are.  Returns 0 if it's an
+   entry, 1 if the line is blank and -1 if it's wrong. */
+int SrcSplit(char *line, const char *name, size_t lineno, char **word, char **def)
+{
+  size_t len = strlen(line);
+  char *tab, *p;
+
+  while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+    line[--len] = '\0';
+  if (len == 0)
+    return 1;
+
+  tab = strchr(line, '\t');
+  if (!tab || strchr(tab + 1, '\t'))
+    {
+      fprintf(stderr, "%s:%zu: not a word, a tab and a definition\n", name, lineno);
+      return -1;
+    }
+  *tab = '\0';
+
+  if (tab == line || tab - line > DICTWORDMAX)
+    {
+      fprintf(stderr, "%s:%zu: word missing or longer than %d\n", name, lineno, DICTWORDMAX);
+      return -1;
+    }
+
+  for (p = line; *p; p++)
+    if (*p >= 'A' && *p <= 'Z')
+      *p += 'a' - 'A';
+
+  *word = line;
+  *def = tab + 1;
+  return 0;
+}
+
+
+
+/* Read the entries of f (called name in messages) onto the end of src */
+int SrcRead(FILE *f, const char *name, srcType *src)
+{
+  char *line = NULL, *word, *def;
+  size_t cap = 0, lineno = 0;
+  int err = 0, r;
+
+  while (err == 0 && getline(&line, &cap, f) >= 0)
+    {
+      r = SrcSplit(line, name, ++lineno, &word, &def);
+      if (r < 0)
+	err = -1;
+      else if (r == 0 && SrcAdd(src, word, def) < 0)
+	{
+	  fprintf(stderr, "out of memory\n");
+	  err = -1;
+	}
+    }
+
+  free(line);
+  return err;
+}
+
+
+
+/* Make sure the words are in order and appear once */
+int SrcCheck(const srcType *src)
+{
+  size_t i;
+
+  for (i = 1; i < src->n; i++)
+    if (strcmp(src->e[i - 1].word, src->e[i].word) >= 0)
+      {
+	fprintf(stderr, "\"%s\" %s \"%s\" - the source must be sorted\n",
+		src->e[i].word,
+		strcmp(src->e[i - 1].word, src->e[i].word) ? "comes after" : "repeats",
+		src->e[i - 1].word);
+	return -1;
+      }
+
+  return 0;
+}
+
+
+
+void SrcFree(srcType *src)
+{
+  size_t i;
+
+  for (i = 0; i < src->n; i++)
+    {
+      free(src->e[i].word);
+      free(src->e[i].def);
+    }
+  free(src->e);
+  memset(src, 0, sizeof(srcType));
+}
+
+
+
+/* Seconds on a clock that only goes forward, for timing */
+double Now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+
+/* Big-endian fields, as the Palm reads them */
+void Put16(unsigned char *p, unsigned long v)
+{
+  p[0] = (v >> 8) & 0xFF;
+  p[1] = v & 0xFF;
+}
+
+
+
+void Put32(unsigned char *p, unsigned long v)
+{
+  Put16(p, v >> 16);
+  Put16(p + 2, v & 0xFFFF);
+}
+
+
+
+/* Add a record of size bytes (data is the image's to free) */
+void ImageAdd(imageType *img, unsigned char *data, size_t size)
+{
+  img->rec = Grow(img->rec, &img->cap, img->n, sizeof(recType));
+  img->rec[img->n].data = data;
+  img->rec[img->n].size = size;
+  img->n++;
+  img->bytes += size;
+}
+
+
+
+/* Entries first to last-1 as a plain record */
+static int BuildPlain(const srcType *src, size_t first, size_t last, imageType *img)
+{
+  unsigned char *data, *p;
+  size_t i, size = 0;
+
+  for (i = first; i < last; i++)
+    size += strlen(src->e[i].word) + strlen(src->e[i].def) + 2;
+
+  if (size > 0xFFFF)
+    {
+      fprintf(stderr, "record at \"%s\" is over 64K\n", src->e[first].word);
+      return -1;
+    }
+
+  p = data = malloc(size);
+  if (!data)
+    return -1;
+
+  for (i = first; i < last; i++)
+    {
+      p += sprintf((char *) p, "%s\t%s", src->e[i].word, src->e[i].def);
+      *p++ = (i + 1 < last) ? '\t' : '\0';
+    }
+
+  ImageAdd(img, data, size);
+  return 0;
+}
+
+
+
+/* Turn "\n" into newlines, as the Palm shows them, and check that the
+   text leaves the top half of the byte free for pair codes */
+static int Unescape(const char *word, const char *def, packDefType *d)
+{
+  const unsigned char *s = (const unsigned char *) def;
+
+  d->s = malloc(strlen(def) + 1);
+  if (!d->s)
+    return -1;
+
+  for (d->len = 0; *s; s++)
+    {
+      if (*s >= DICTPAIRBASE)
+	{
+	  fprintf(stderr, "definition of \"%s\" isn't 7-bit text\n", word);
+	  return -1;
+	}
+
+      if (s[0] == '\\' && s[1] == 'n')
+	{
+	  d->s[d->len++] = '\n';
+	  s++;
+	}
+      else
+	d->s[d->len++] = *s;
+    }
+
+  d->rawlen = d->len;
+  return 0;
+}
+
+
+
+/* Pair counts for Pair() - the count of each pair and the pairs that
+   have turned up, so that only those are looked through */
+typedef struct
+{
+  unsigned long  count[65536];
+  unsigned char  listed[65536];
+  unsigned short seen[65536];
+  size_t         nseen;
+} pairCountType;
+
+
+static void PairAdd(pairCountType *pc, unsigned a, unsigned b)
+{
+  unsigned k = (a << 8) | b;
+
+  if (pc->count[k]++ == 0 && !pc->listed[k])
+    {
+      pc->listed[k] = 1;
+      pc->seen[pc->nseen++] = k;
+    }
+}
+
+
+#define PairSub(pc, a, b)  ((pc)->count[((a) << 8) | (b)]--)
+
+
+
+/* Pair up the bytes of the n definitions in defs, filling in pairs.
+   Returns the number of pairs.  The pairs are counted once; after
+   that replacing a pair only changes the counts of the pairs either
+   side of it, so each code costs a pass over the text rather than a
+   recount of it. */
+static size_t Pair(packDefType *defs, size_t n, unsigned char pairs[DICTPAIRS][2])
+{
+  static pairCountType pc;
+  unsigned char depth[256] = { 0 };
+  unsigned long most;
+  size_t code, i, j, k, best, len, next;
+  unsigned char a, b, c, *s, *p;
+
+  for (i = 0; i < n; i++)
+    for (j = 0; j + 1 < defs[i].len; j++)
+      PairAdd(&pc, defs[i].s[j], defs[i].s[j + 1]);
+
+  for (code = 0; code < DICTPAIRS; code++)
+    {
+      /* The commonest pair that doesn't nest too deep to unpack */
+      most = 0;
+      best = 0;
+      for (i = 0; i < pc.nseen; i++)
+	{
+	  k = pc.seen[i];
+	  if (pc.count[k] > most
+	      && (depth[k >> 8] > depth[k & 0xFF] ? depth[k >> 8] : depth[k & 0xFF]) < DICTPAIRDEPTH - 2)
+	    {
+	      most = pc.count[k];
+	      best = k;
+	    }
+	}
+
+      if (most <= PAIRMIN)
+	break;
+      a = best >> 8;
+      b = best & 0xFF;
+      c = DICTPAIRBASE + code;
+      pairs[code][0] = a;
+      pairs[code][1] = b;
+      depth[c] = 1 + (depth[a] > depth[b] ? depth[a] : depth[b]);
+
+      /* Text is read at j and written back at k, skipping from one a
+	 to the next.  The pair before a replacement is in what's been
+	 written, and the one after it still in what's to be read. */
+      for (i = 0; i < n; i++)
+	{
+	  s = defs[i].s;
+	  len = defs[i].len;
+	  for (j = 0, k = 0; j < len; )
+	    {
+	      p = memchr(s + j, a, len - j);
+	      next = p ? (size_t) (p - s) : len;
+	      if (next + 1 >= len || s[next + 1] != b)
+		next = p ? next + 1 : len;
+	      if (k < j)
+		memmove(s + k, s + j, next - j);
+	      k += next - j;
+	      j = next;
+
+	      if (j + 1 < len && s[j] == a && s[j + 1] == b)
+		{
+		  PairSub(&pc, a, b);
+		  if (k > 0)
+		    {
+		      PairSub(&pc, s[k - 1], a);
+		      PairAdd(&pc, s[k - 1], c);
+		    }
+		  if (j + 2 < len)
+		    {
+		      PairSub(&pc, b, s[j + 2]);
+		      PairAdd(&pc, c, s[j + 2]);
+		    }
+		  s[k++] = c;
+		  j += 2;
+		}
+	    }
+	  defs[i].len = k;
+	}
+    }
+
+  /* Leave the counts clear for the next record */
+  for (i = 0; i < pc.nseen; i++)
+    {
+      pc.count[pc.seen[i]] = 0;
+      pc.listed[pc.seen[i]] = 0;
+    }
+  pc.nseen = 0;
+
+  return code;
+}
+
+
+
+/* Entries first to last-1 as a packed record */
+static int BuildPacked(const srcType *src, size_t first, size_t last, imageType *img)
+{
+  unsigned char pairs[DICTPAIRS][2];
+  packDefType *defs;
+  unsigned char *data, *p;
+  const char *word, *prev = "";
+  size_t i, n = last - first, npairs, size, prefix, suffix;
+  int err = -1;
+
+  defs = calloc(n, sizeof(packDefType));
+  if (!defs)
+    return -1;
+
+  for (i = 0; i < n; i++)
+    if (Unescape(src->e[first + i].word, src->e[first + i].def, &defs[i]) < 0)
+      goto done;
+
+  npairs = Pair(defs, n, pairs);
+
+  size = sizeof(dictPackHeaderType) + 2 * npairs;
+  for (i = 0; i < n; i++)
+    size += 6 + strlen(src->e[first + i].word) + defs[i].len;
+
+  p = data = malloc(size);
+  if (!data)
+    goto done;
+
+  p[0] = DICTPACKMAGIC;
+  p[1] = DICTPACKVERSION;
+  Put16(p + 2, n);
+  Put16(p + 6, npairs);
+  p += sizeof(dictPackHeaderType);
+
+  memcpy(p, pairs, 2 * npairs);
+  p += 2 * npairs;
+
+  for (i = 0; i < n; i++)
+    {
+      word = src->e[first + i].word;
+      for (prefix = 0; word[prefix] && word[prefix] == prev[prefix]; prefix++)
+	;
+      suffix = strlen(word) - prefix;
+
+      *p++ = prefix;
+      *p++ = suffix;
+      memcpy(p, word + prefix, suffix);
+      p += suffix;
+
+      Put16(p, defs[i].len);
+      Put16(p + 2, defs[i].rawlen);
+      memcpy(p + 4, defs[i].s, defs[i].len);
+      p += 4 + defs[i].len;
+
+      prev = word;
+    }
+
+  /* Front coding makes it shorter than counted */
+  size = p - data;
+  if (size > 0xFFFF || n > 0xFFFF)
+    {
+      fprintf(stderr, "record at \"%s\" is over 64K packed\n", src->e[first].word);
+      free(data);
+      goto done;
+    }
+  Put16(data + 4, size);
+
+  ImageAdd(img, data, size);
+  err = 0;
+
+ done:
+  for (i = 0; i < n; i++)
+    free(defs[i].s);
+  free(defs);
+
+  return err;
+}
+
+
+
+/* Start an empty dictionary of plain or packed records of about
+   recsize unpacked bytes each */
+void ImageInit(imageType *img, int packed, size_t recsize)
+{
+  memset(img, 0, sizeof(imageType));
+
+  img->packed = packed;
+  img->recsize = (recsize > DICTRECMAX) ? DICTRECMAX : recsize;
+}
+
+
+
+/* Make a record of the entries waiting */
+static int ImageFlush(imageType *img)
+{
+  int err = 0;
+
+  if (img->pending.n > 0)
+    err = (img->packed ? BuildPacked : BuildPlain)(&img->pending, 0, img->pending.n, img);
+
+  SrcFree(&img->pending);
+  img->pendingsize = 0;
+
+  return err;
+}
+
+
+
+/* Add the next entry.  Entries must come in order - a record is made
+   each time there are enough of them. */
+int ImageEntry(imageType *img, const char *word, const char *def)
+{
+  size_t size = strlen(word) + strlen(def) + 2;
+
+  if (img->pending.n > 0 && img->pendingsize + size > img->recsize
+      && ImageFlush(img) < 0)
+    return -1;
+
+  img->pendingsize += size;
+  return SrcAdd(&img->pending, word, def);
+}
+
+
+
+/* Make a record of what's left */
+int ImageFinish(imageType *img)
+{
+  return ImageFlush(img);
+}
+
+
+
+/* Cut the whole of src into records */
+int ImageBuild(const srcType *src, int packed, size_t recsize, imageType *img)
+{
+  size_t i;
+
+  ImageInit(img, packed, recsize);
+
+  for (i = 0; i < src->n; i++)
+    if (ImageEntry(img, src->e[i].word, src->e[i].def) < 0)
+      break;
+
+  if (i < src->n || ImageFinish(img) < 0)
+    {
+      ImageFree(img);
+      return -1;
+    }
+
+  return 0;
+}
+
+
+
+void ImageFree(imageType *img)
+{
+  size_t i;
+
+  for (i = 0; i < img->n; i++)
+    free(img->rec[i].data);
+  free(img->rec);
+  SrcFree(&img->pending);
+  memset(img, 0, sizeof(imageType));
+}
+
+
+
+/* Make the first-word index of img, as dict.h's dictIndexType and what
+   follows it, for the app info block.  Returns NULL if the first words
+   come to more than the 64K it can hold. */
+unsigned char *ImageIndex(const imageType *img, const char *title, size_t *size)
+{
+  char words[DICTWORDMAX + 1];
+  unsigned char *data, *p;
+  size_t i, keysize = 0, len;
+
+  for (i = 0; i < img->n; i++)
+    keysize += DictRecFirstWord(img->rec[i].data, img->rec[i].size, words, DICTWORDMAX) + 1;
+
+  if (keysize > 0xFFFF || img->n > 0xFFFF)
+    return NULL;
+
+  *size = INDEXHEADER + 2 * img->n + keysize;
+  data = calloc(*size, 1);
+  if (!data)
+    return NULL;
+
+  strncpy((char *) data, title, INDEXTITLE - 1);
+  memcpy(data + INDEXTITLE, DICTINDEXMAGICSTR, 4);
+  Put32(data + INDEXTITLE + 4, 0);          /* Modification number - not checked */
+  Put16(data + INDEXTITLE + 8, img->n);
+  Put16(data + INDEXTITLE + 10, keysize);
+
+  p = data + INDEXHEADER + 2 * img->n;
+  for (i = 0; i < img->n; i++)
+    {
+      Put16(data + INDEXHEADER + 2 * i, p - (data + INDEXHEADER + 2 * img->n));
+      len = DictRecFirstWord(img->rec[i].data, img->rec[i].size, (char *) p, DICTWORDMAX);
+      p += len + 1;
+    }
+
+  return data;
+}
+
+
+
+/* Write img to f as the PDB called name, with the app info block of
+   appsize bytes if appinfo isn't NULL */
+int PdbWrite(FILE *f, const char *name, const char *type, const char *creator,
+	     const unsigned char *appinfo, size_t appsize, const imageType *img)
+{
+  unsigned char hdr[78], entry[8];
+  unsigned long now = (unsigned long) time(NULL) + PALMEPOCH;
+  unsigned long offset;
+  size_t i;
+
+  if (img->n > 0xFFFF)
+    {
+      fprintf(stderr, "too many records\n");
+      return -1;
+    }
+
+  memset(hdr, 0, sizeof(hdr));
+  strncpy((char *) hdr, name, 31);
+  Put16(hdr + 34, 1);            /* Version */
+  Put32(hdr + 36, now);          /* Created */
+  Put32(hdr + 40, now);          /* Modified */
+  memcpy(hdr + 60, type, 4);
+  memcpy(hdr + 64, creator, 4);
+  Put32(hdr + 68, img->n + 1);   /* Unique ID seed */
+  Put16(hdr + 76, img->n);
+
+  /* The record list, then two bytes of padding, then the app info
+     block and the records */
+  offset = sizeof(hdr) + 8 * img->n + 2;
+  if (appinfo)
+    {
+      Put32(hdr + 52, offset);
+      offset += appsize;
+    }
+  fwrite(hdr, sizeof(hdr), 1, f);
+
+  for (i = 0; i < img->n; i++)
+    {
+      Put32(entry, offset);
+      entry[4] = 0;
+      entry[5] = ((i + 1) >> 16) & 0xFF;
+      Put16(entry + 6, (i + 1) & 0xFFFF);
+      fwrite(entry, sizeof(entry), 1, f);
+      offset += img->rec[i].size;
+    }
+  fwrite("\0\0", 2, 1, f);
+
+  if (appinfo)
+    fwrite(appinfo, appsize, 1, f);
+
+  for (i = 0; i < img->n; i++)
+    fwrite(img->rec[i].data, img->rec[i].size, 1, f);
+
+  return ferror(f) ? -1 : 0;
+}
@@ -0,0 +1,91 @@
+/* Building the dictionary on the host.
+
+   The source is text, one entry to a line in any order:
+
+       word<TAB>definition
+
+   with newlines in definitions written as "\n" - the same as the
+   entries of a plain record.  Words are lowercased as they're read.
+   It is sorted first (see dictsort.h), with repeated words dropped,
+   then cut into records, plain or packed (see dictrec.h), and written
+   out as a PDB for lfdict.  The PDB's app info block holds the index
+   of the first word of each record that dict.c would otherwise have
+   to read every record to make. */
+
+#ifndef DICTBUILD_H
+#define DICTBUILD_H
+
+#include <stdio.h>
+
+/* Type and creator of lfdict */
+#define DICTDBTYPE        "Dict"
+#define DICTDBCREATOR     "shLF"
+
+/* Longest word - MAXDBTITLE in lf.h */
+#define DICTWORDMAX       32
+
+/* Unpacked entry bytes to put in each record unless asked otherwise.
+   Records can't be more than 64K and some space is kept for packing
+   overhead when nothing packs. */
+#define DICTRECSIZE       16384
+#define DICTRECMAX        49152
+
+/* srcEntryType - An entry of the source */
+typedef struct
+{
+  char         *word;
+  char         *def;
+} srcEntryType;
+
+/* srcType - The whole source */
+typedef struct
+{
+  srcEntryType *e;
+  size_t        n, cap;
+} srcType;
+
+/* recType - A record of the dictionary */
+typedef struct
+{
+  unsigned char *data;
+  size_t         size;
+} recType;
+
+/* imageType - The records of the dictionary, and the entries waiting
+   to go in the next one */
+typedef struct
+{
+  recType      *rec;
+  size_t        n, cap;
+  size_t        bytes;     /* Bytes in all the records */
+
+  int           packed;
+  size_t        recsize;
+  srcType       pending;
+  size_t        pendingsize;
+} imageType;
+
+int   SrcSplit(char *line, const char *name, size_t lineno, char **word, char **def);
+int   SrcRead(FILE *f, const char *name, srcType *src);
+int   SrcAdd(srcType *src, const char *word, const char *def);
+int   SrcCheck(const srcType *src);
+void  SrcFree(srcType *src);
+
+void  ImageInit(imageType *img, int packed, size_t recsize);
+void  ImageAdd(imageType *img, unsigned char *data, size_t size);
+int   ImageEntry(imageType *img, const char *word, const char *def);
+int   ImageFinish(imageType *img);
+int   ImageBuild(const srcType *src, int packed, size_t recsize, imageType *img);
+void  ImageFree(imageType *img);
+
+unsigned char *ImageIndex(const imageType *img, const char *title, size_t *size);
+
+int   PdbWrite(FILE *f, const char *name, const char *type, const char *creator,
+	       const unsigned char *appinfo, size_t appsize, const imageType *img);
+
+/* Shared by the tools */
+double Now(void);
+void  Put16(unsigned char *p, unsigned long v);
+void  Put32(unsigned char *p, unsigned long v);
+
+#endif
@@ -0,0 +1,328 @@
+/* -----------------------------------------------------------------------------
+   External merge sort of the dictionary source.
+
+   A run is held as one block of text with an array of entries pointing
+   into it.  Entries are numbered as they're read so that sorting a run
+   keeps repeated words in source order, and merging takes the earlier
+   run first when words are equal - the first of a repeated word always
+   comes out first and the rest are dropped.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dictbuild.h"
+#include "dictsort.h"
+
+
+/* An entry of a run in memory */
+typedef struct
+{
+  char         *word;
+  char         *def;
+  size_t        seq;
+} sortEntryType;
+
+/* The run being read */
+typedef struct
+{
+  char         *text;
+  size_t        used, size;
+  sortEntryType *e;
+  size_t        n, cap;
+} sortRunType;
+
+/* A run being merged */
+typedef struct
+{
+  FILE         *f;
+  char         *line;
+  size_t        cap;
+  char         *word, *def;
+} sortFileType;
+
+
+
+static int CompareEntries(const void *a, const void *b)
+{
+  const sortEntryType *x = a, *y = b;
+  int c = strcmp(x->word, y->word);
+
+  if (c)
+    return c;
+
+  return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+
+
+/* Pass on an entry unless it repeats the word before */
+static int Emit(const char *word, const char *def, char *last, sortOutType out,
+		void *ctx, sortStatsType *stats)
+{
+  if (strcmp(word, last) == 0)
+    {
+      stats->repeats++;
+      return 0;
+    }
+
+  strcpy(last, word);
+  return out(ctx, word, def);
+}
+
+
+
+/* Write the sorted run to a new temporary file */
+static FILE *WriteRun(sortRunType *run)
+{
+  FILE *f = tmpfile();
+  size_t i;
+
+  if (!f)
+    {
+      perror("temporary file");
+      return NULL;
+    }
+
+  for (i = 0; i < run->n; i++)
+    fprintf(f, "%s\t%s\n", run->e[i].word, run->e[i].def);
+
+  if (fflush(f) != 0 || ferror(f))
+    {
+      perror("temporary file");
+      fclose(f);
+      return NULL;
+    }
+
+  rewind(f);
+  return f;
+}
+
+
+
+/* Read the next entry of a run being merged.  Returns false at its end. */
+static int NextOfRun(sortFileType *r)
+{
+  char *tab;
+
+  if (getline(&r->line, &r->cap, r->f) < 0)
+    return 0;
+
+  r->line[strcspn(r->line, "\n")] = '\0';
+  tab = strchr(r->line, '\t');
+  *tab = '\0';
+  r->word = r->line;
+  r->def = tab + 1;
+
+  return 1;
+}
+
+
+
+/* Does run a come before run b (by word and then by run)? */
+#define Before(runs, a, b) \
+  (strcmp((runs)[a].word, (runs)[b].word) < 0 \
+   || (strcmp((runs)[a].word, (runs)[b].word) == 0 && (a) < (b)))
+
+/* Put the run at heap[i] where it belongs below i */
+static void SiftDown(sortFileType *runs, size_t *heap, size_t n, size_t i)
+{
+  size_t c, t;
+
+  while ((c = 2 * i + 1) < n)
+    {
+      if (c + 1 < n && Before(runs, heap[c + 1], heap[c]))
+	c++;
+      if (!Before(runs, heap[c], heap[i]))
+	break;
+
+      t = heap[i];
+      heap[i] = heap[c];
+      heap[c] = t;
+      i = c;
+    }
+}
+
+
+
+/* Merge the runs in files, taking the smallest head each time */
+static int Merge(FILE **files, size_t nfiles, sortOutType out, void *ctx,
+		 sortStatsType *stats)
+{
+  sortFileType *runs = calloc(nfiles, sizeof(sortFileType));
+  size_t *heap = malloc(nfiles * sizeof(size_t));
+  char last[DICTWORDMAX + 1] = "";
+  size_t i, n = 0, top;
+  int err = 0;
+
+  if (!runs || !heap)
+    {
+      fprintf(stderr, "out of memory\n");
+      free(runs);
+      free(heap);
+      return -1;
+    }
+
+  for (i = 0; i < nfiles; i++)
+    {
+      runs[i].f = files[i];
+      if (NextOfRun(&runs[i]))
+	heap[n++] = i;
+    }
+
+  for (i = n; i-- > 0; )
+    SiftDown(runs, heap, n, i);
+
+  while (n > 0 && err == 0)
+    {
+      top = heap[0];
+      err = Emit(runs[top].word, runs[top].def, last, out, ctx, stats);
+
+      if (!NextOfRun(&runs[top]))
+	heap[0] = heap[--n];
+      SiftDown(runs, heap, n, 0);
+    }
+
+  for (i = 0; i < nfiles; i++)
+    free(runs[i].line);
+  free(runs);
+  free(heap);
+
+  return err;
+}
+
+
+
+/* Read f (called name in messages), sort it in runs of at most budget
+   bytes and pass each entry on to out in order */
+int SortSource(FILE *f, const char *name, size_t budget, sortOutType out,
+	       void *ctx, sortStatsType *stats)
+{
+  sortRunType run = { 0 };
+  FILE **files = NULL;
+  size_t nfiles = 0, cap = 0, linecap = 0, lineno = 0, len, i;
+  char *line = NULL, *word, *def, last[DICTWORDMAX + 1] = "";
+  int err = 0, r, eof = 0, carry = 0;
+
+  memset(stats, 0, sizeof(sortStatsType));
+
+  run.size = budget;
+  run.text = malloc(run.size);
+  if (!run.text)
+    {
+      fprintf(stderr, "out of memory\n");
+      return -1;
+    }
+
+  while (err == 0 && !eof)
+    {
+      /* Fill a run */
+      run.used = 0;
+      run.n = 0;
+      for (;;)
+	{
+	  /* The entry that didn't fit in the last run goes first */
+	  if (!carry)
+	    {
+	      if (getline(&line, &linecap, f) < 0)
+		{
+		  eof = 1;
+		  break;
+		}
+
+	      r = SrcSplit(line, name, ++lineno, &word, &def);
+	      if (r < 0)
+		{
+		  err = -1;
+		  break;
+		}
+	      if (r > 0)
+		continue;
+
+	      /* Counted as the run counts it below, or it would never fit
+		 even an empty run */
+	      len = strlen(word) + strlen(def) + 2;
+	      if (len + sizeof(sortEntryType) > run.size)
+		{
+		  fprintf(stderr, "%s:%zu: entry is bigger than the memory allowed\n", name, lineno);
+		  err = -1;
+		  break;
+		}
+	    }
+	  carry = 0;
+
+	  /* The entry array counts against the memory too */
+	  if (run.used + len + (run.n + 1) * sizeof(sortEntryType) > run.size)
+	    {
+	      carry = 1;
+	      break;
+	    }
+
+	  if (run.n == run.cap)
+	    {
+	      run.cap = run.cap ? 2 * run.cap : 4096;
+	      run.e = realloc(run.e, run.cap * sizeof(sortEntryType));
+	      if (!run.e)
+		{
+		  fprintf(stderr, "out of memory\n");
+		  exit(1);
+		}
+	    }
+
+	  run.e[run.n].word = run.text + run.used;
+	  strcpy(run.e[run.n].word, word);
+	  run.e[run.n].def = run.e[run.n].word + strlen(word) + 1;
+	  strcpy(run.e[run.n].def, def);
+	  run.e[run.n].seq = stats->entries++;
+	  run.n++;
+	  run.used += len;
+	}
+
+      if (err)
+	break;
+
+      qsort(run.e, run.n, sizeof(sortEntryType), CompareEntries);
+
+      /* It all fitted - no need for files */
+      if (eof && nfiles == 0)
+	{
+	  for (i = 0; i < run.n && err == 0; i++)
+	    err = Emit(run.e[i].word, run.e[i].def, last, out, ctx, stats);
+	  break;
+	}
+
+      if (run.n > 0)
+	{
+	  if (nfiles == cap)
+	    {
+	      cap = cap ? 2 * cap : 16;
+	      files = realloc(files, cap * sizeof(FILE *));
+	      if (!files)
+		{
+		  fprintf(stderr, "out of memory\n");
+		  exit(1);
+		}
+	    }
+
+	  files[nfiles] = WriteRun(&run);
+	  if (!files[nfiles])
+	    err = -1;
+	  else
+	    nfiles++;
+	}
+    }
+
+  free(line);
+  free(run.text);
+  free(run.e);
+
+  if (err == 0 && nfiles > 0)
+    err = Merge(files, nfiles, out, ctx, stats);
+
+  stats->runs = nfiles;
+  for (i = 0; i < nfiles; i++)
+    fclose(files[i]);
+  free(files);
+
+  return err;
+}
@@ -0,0 +1,32 @@
+/* Sorting the dictionary source.
+
+   The source is read a run at a time - as many entries as fit in the
+   memory allowed - and each run is sorted.  If it all fits in one run
+   it is passed on straight from memory, otherwise the sorted runs are
+   written to temporary files and merged.  Entries come out in the order
+   the Palm compares words in, and when a word turns up more than once
+   only the first (in the source) is kept. */
+
+#ifndef DICTSORT_H
+#define DICTSORT_H
+
+#include <stdio.h>
+
+/* Memory for a run unless asked otherwise */
+#define SORTBUDGET      (64UL << 20)
+
+/* sortStatsType - How the sort went */
+typedef struct
+{
+  size_t        entries;   /* Read */
+  size_t        repeats;   /* Dropped as repeated words */
+  size_t        runs;      /* Written to temporary files - 0 if it fitted */
+} sortStatsType;
+
+/* Called with each entry in order.  Returns < 0 to stop the sort. */
+typedef int (*sortOutType)(void *ctx, const char *word, const char *def);
+
+int SortSource(FILE *f, const char *name, size_t budget, sortOutType out,
+	       void *ctx, sortStatsType *stats);
+
+#endif
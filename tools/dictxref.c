@@ -0,0 +1,218 @@
+/* -----------------------------------------------------------------------------
+   Finding the cross-references in the dictionary's definitions.
+
+   The records are read back once for every word and where it is, then
+   once more for the definitions - as the Palm will show them - to find
+   the references in.  Words come out of the records sorted, so finding
+   one is a binary search.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <PalmOS.h>
+#include "dictrec.h"
+#include "dictbuild.h"
+#include "dictxref.h"
+
+
+/* dictXrefHeaderType in dictrec.h */
+#define DICTXREFMAGICSTR  "LFDR"
+#define XREFHEADER        6
+
+
+/* A word of the dictionary and where it is */
+typedef struct
+{
+  char         *word;
+  UInt16        rec;
+  UInt16        entry;
+} xrefWordType;
+
+/* A record's entries */
+typedef struct
+{
+  dictKeyType  *keys;
+  char         *words;
+  const char   *base;      /* What the keys' words are offsets into */
+  UInt16        count;
+} xrefTableType;
+
+
+
+static int CompareWord(const void *key, const void *w)
+{
+  return strcmp(key, ((const xrefWordType *) w)->word);
+}
+
+
+
+static int TableRead(const recType *r, xrefTableType *t)
+{
+  UInt16 wordsize;
+
+  t->count = DictRecScan(r->data, r->size, NULL, NULL, &wordsize);
+  t->keys = malloc((t->count + 1) * sizeof(dictKeyType));
+  t->words = malloc(wordsize + 1);
+  if (!t->keys || !t->words)
+    return -1;
+
+  DictRecScan(r->data, r->size, t->keys, t->words, NULL);
+  t->base = wordsize ? t->words : (const char *) r->data;
+  return 0;
+}
+
+
+
+/* The definition of key as the Palm shows it, in out.  Returns its
+   length. */
+static size_t Shown(const recType *r, const dictKeyType *k, char *out)
+{
+  const char *s, *end;
+  char *d = out;
+
+  if (DictRecIsPacked(r->data, r->size))
+    return DictRecUnpack(r->data, k, out);
+
+  s = (const char *) r->data + k->def;
+  end = s + k->deflen;
+  while (s < end)
+    {
+      if (s[0] == '\\' && s + 1 < end && s[1] == 'n')
+	{
+	  *d++ = '\n';
+	  s += 2;
+	}
+      else
+	*d++ = *s++;
+    }
+
+  return d - out;
+}
+
+
+
+/* Make the cross-reference DB of img in xref - the header record and a
+   record for each of img's - counting the references in *refs.  A
+   record with more references than fit in 64K keeps the first ones. */
+int XrefBuild(const imageType *img, imageType *xref, size_t *refs)
+{
+  static char def[0x10000];
+  xrefWordType *all = NULL, *found;
+  xrefTableType t;
+  size_t nall = 0, cap = 0, i, len, at, size, used;
+  unsigned char *data, *first;
+  char word[DICTWORDMAX + 1], last[DICTWORDMAX + 1];
+  UInt16 e, n;
+  int caps;
+
+  memset(xref, 0, sizeof(imageType));
+  *refs = 0;
+
+  if (img->n > 0xFFFF)
+    return -1;
+
+  /* Every word and where it is */
+  for (i = 0; i < img->n; i++)
+    {
+      if (TableRead(&img->rec[i], &t) < 0)
+	return -1;
+
+      for (e = 0; e < t.count; e++)
+	{
+	  if (nall == cap)
+	    {
+	      cap = cap ? 2 * cap : 65536;
+	      all = realloc(all, cap * sizeof(xrefWordType));
+	      if (!all)
+		return -1;
+	    }
+	  all[nall].word = strndup(t.base + t.keys[e].word, t.keys[e].wordlen);
+	  all[nall].rec = i;
+	  all[nall].entry = e;
+	  nall++;
+	}
+
+      free(t.keys);
+      free(t.words);
+    }
+
+  data = malloc(XREFHEADER);
+  if (!data)
+    return -1;
+  memcpy(data, DICTXREFMAGICSTR, 4);
+  Put16(data + 4, img->n);
+  ImageAdd(xref, data, XREFHEADER);
+
+  /* The references in each record's definitions */
+  for (i = 0; i < img->n; i++)
+    {
+      if (TableRead(&img->rec[i], &t) < 0)
+	return -1;
+
+      data = malloc(0x10000);
+      if (!data)
+	return -1;
+      Put16(data, t.count);
+      first = data + 2;
+      used = 2 + 2 * (t.count + 1);
+      size = 0;
+
+      for (e = 0; e < t.count; e++)
+	{
+	  Put16(first + 2 * e, (used - (2 + 2 * (t.count + 1))) / DICTXREFREF);
+
+	  len = Shown(&img->rec[i], &t.keys[e], def);
+	  last[0] = '\0';
+	  for (at = 0; at < len; )
+	    {
+	      if (!isalpha((unsigned char) def[at]))
+		{
+		  at++;
+		  continue;
+		}
+
+	      /* A word of the definition */
+	      caps = 1;
+	      for (n = 0; at + n < len && isalpha((unsigned char) def[at + n]); n++)
+		{
+		  if (!isupper((unsigned char) def[at + n]))
+		    caps = 0;
+		  if (n < DICTWORDMAX)
+		    word[n] = tolower((unsigned char) def[at + n]);
+		}
+	      word[n < DICTWORDMAX ? n : DICTWORDMAX] = '\0';
+
+	      if (n <= DICTWORDMAX && ((caps && n > 1) || strcmp(last, "see") == 0)
+		  && DictRecCompare(word, t.base + t.keys[e].word, t.keys[e].wordlen) != 0
+		  && used + DICTXREFREF <= 0xFFFF
+		  && (found = bsearch(word, all, nall, sizeof(xrefWordType), CompareWord)))
+		{
+		  Put16(data + used, at);
+		  Put16(data + used + 2, n);
+		  Put16(data + used + 4, found->rec);
+		  Put16(data + used + 6, found->entry);
+		  used += DICTXREFREF;
+		  size++;
+		}
+
+	      strcpy(last, word);
+	      at += n;
+	    }
+	}
+      Put16(first + 2 * t.count, (used - (2 + 2 * (t.count + 1))) / DICTXREFREF);
+
+      ImageAdd(xref, realloc(data, used), used);
+      *refs += size;
+
+      free(t.keys);
+      free(t.words);
+    }
+
+  for (i = 0; i < nall; i++)
+    free(all[i].word);
+  free(all);
+
+  return 0;
+}
@@ -0,0 +1,20 @@
+/* The cross-reference DB of the dictionary.
+
+   A word in a definition refers to another entry if it's written in
+   capitals ("a kind of BOAT") or comes after "see" ("see boat"), and
+   is a word of the dictionary other than the one being defined.  For
+   each record of the dictionary there's a record of where these
+   references are and the entries they lead to - the layout is in
+   dictrec.h - so the Palm can follow one without searching. */
+
+#ifndef DICTXREF_H
+#define DICTXREF_H
+
+#include "dictbuild.h"
+
+/* Type of the cross-reference DB */
+#define DICTXREFDBTYPE    "Xref"
+
+int XrefBuild(const imageType *img, imageType *xref, size_t *refs);
+
+#endif
@@ -0,0 +1,45 @@
+/* Host stand-in for PalmOS.h.
+
+   Lets the parts of LAMPFlash that don't touch the UI or the Data Manager
+   (the quiz engine, random numbers and so on) be built with the host
+   compiler for the tools and benchmarks in this directory.  Only what
+   those files use is provided. */
+
+#ifndef HOST_PALMOS_H
+#define HOST_PALMOS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t         UInt8;
+typedef int8_t          Int8;
+typedef uint16_t        UInt16;
+typedef int16_t         Int16;
+typedef uint32_t        UInt32;
+typedef int32_t         Int32;
+typedef char            Char;
+typedef unsigned char   Boolean;
+typedef UInt16          Err;
+
+#ifndef true
+#define true            1
+#define false           0
+#endif
+
+#define errNone                 0x0000
+#define memErrNotEnoughSpace    0x0102
+#define dmErrCorruptDatabase    0x0209
+
+#define MemPtrNew(size)         malloc(size)
+#define MemPtrFree(p)           free(p)
+#define MemSet(p, n, v)         memset((p), (v), (n))
+#define MemMove(d, s, n)        memmove((d), (s), (n))
+#define MemCmp(a, b, n)         memcmp((a), (b), (n))
+
+#define StrLen(s)               strlen(s)
+#define StrCopy(d, s)           strcpy((d), (s))
+#define StrCompare(a, b)        strcmp((a), (b))
+#define StrNCompare(a, b, n)    strncmp((a), (b), (n))
+
+#endif
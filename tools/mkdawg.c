@@ -0,0 +1,353 @@
+/* -----------------------------------------------------------------------------
+   mkdawg - compile the lexicon PDB from a word list.
+
+   Usage: mkdawg [-g] [-t] [-n name] lexicon.txt lflex.pdb
+
+     -g            add a GADDAG, for quicker front hooks and patterns
+                   that don't start with their letters
+     -t            test the lexicon against the word list, and time
+                   hooks, patterns and the words of racks on it
+     -n name       name of the database on the Palm (default lflex)
+
+   The word list is read as mkdeck reads it - the first word of each
+   line, up to DAWGWORDMAX letters ("-" reads standard input).  See
+   dawg.h for what's written.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <PalmOS.h>
+#include "anagram.h"
+#include "dawg.h"
+#include "dictbuild.h"
+#include "deckbuild.h"
+#include "dawgbuild.h"
+
+
+/* Racks of each size tried by -t */
+#define TESTRACKS       200
+
+/* Shortest word a rack is asked for */
+#define RACKMINLEN      3
+
+static const char bag[] =
+  "AAAAAAAAABBCCDDDDEEEEEEEEEEEEFFGGGHHIIIIIIIIIJKLLLLMMNNNNNN"
+  "OOOOOOOOPPQRRRRRRSSSSTTTTTTUUUUVVWWXYYZ??";
+
+
+static void Usage(void)
+{
+  fprintf(stderr, "usage: mkdawg [-g] [-t] [-n name] lexicon.txt lflex.pdb\n");
+  exit(2);
+}
+
+
+
+static int CompareStrings(const void *a, const void *b)
+{
+  return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+
+
+/* The strings of the GADDAG of lex, as letter codes, in one block */
+static char **Gaddag(const lexType *lex, size_t *n, char **block)
+{
+  char **s, *p;
+  const char *w;
+  size_t i, len, j, k, size = 0;
+
+  *n = 0;
+  for (i = 0; i < lex->n; i++)
+    {
+      len = strlen(LexWord(lex, i));
+      *n += len;
+      size += len * (len + 2);
+    }
+
+  s = malloc(*n * sizeof(char *));
+  *block = malloc(size);
+  if (!s || !*block)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+
+  for (i = 0, *n = 0, p = *block; i < lex->n; i++)
+    {
+      w = LexWord(lex, i);
+      len = strlen(w);
+
+      /* The first j letters backwards, then the rest */
+      for (j = 1; j <= len; j++)
+	{
+	  s[(*n)++] = p;
+	  for (k = j; k > 0; k--)
+	    *p++ = w[k - 1] & 0x1F;
+	  if (j < len)
+	    {
+	      *p++ = DAWGSEPARATOR;
+	      for (k = j; k < len; k++)
+		*p++ = w[k] & 0x1F;
+	    }
+	  *p++ = '\0';
+	}
+    }
+
+  return s;
+}
+
+
+
+static Boolean Count(void *ctx, const Char *word, UInt16 len)
+{
+  (*(size_t *) ctx)++;
+  return true;
+}
+
+
+
+/* The words of random racks of size letters (and blanks) from the bag,
+   found in d and checked against the signatures of the words of lex */
+static size_t TestRacks(const lexType *lex, const anagramSigType *sigs, dawgType *d,
+			size_t size)
+{
+  anagramSigType racksig;
+  char rack[LEXWORDMAX + 1];
+  size_t r, i, found, want, bad = 0, words = 0;
+  double t, walking = 0;
+  int blanks;
+
+  srand(size);
+  for (r = 0; r < TESTRACKS; r++)
+    {
+      for (i = 0; i < size; i++)
+	rack[i] = bag[rand() % (sizeof(bag) - 1)];
+      blanks = AnagramSig(rack, size, &racksig);
+
+      t = Now();
+      found = 0;
+      DawgAnagrams(d, rack, size, RACKMINLEN, Count, &found);
+      walking += Now() - t;
+
+      for (i = 0, want = 0; i < lex->n; i++)
+	if (strlen(LexWord(lex, i)) >= RACKMINLEN && sigs[i].s[0] != ~(UInt32) 0
+	    && AnagramHolds(&racksig, &sigs[i], blanks))
+	  want++;
+
+      bad += found != want;
+      words += found;
+    }
+
+  printf("  racks of %2zu: %8.1f words %9.1f us, %zu wrong\n", size, (double) words / TESTRACKS,
+	 1e6 * walking / TESTRACKS, bad);
+  return bad;
+}
+
+
+
+/* Check every word and its hooks with d, and time it */
+static int Test(const lexType *lex, dawgType *d)
+{
+  static const char *patterns[] = { "*ING", "?A?E", "QU*", "*Z*", "C?T*S", "*" , NULL };
+  uint32_t front, back, dfront, dback;
+  size_t i, bad = 0, found, runs;
+  anagramSigType *sigs;
+  double t;
+  int gaddag, j;
+
+  for (i = 0; i < lex->n; i++)
+    {
+      const char *w = LexWord(lex, i);
+
+      LexHooks(lex, w, strlen(w), &front, &back);
+      if (!DawgHas(d, w, strlen(w)))
+	bad++;
+
+      DawgHooks(d, w, strlen(w), &dfront, &dback);
+      if (dfront != front || dback != back)
+	bad++;
+    }
+  printf("  %zu words and their hooks checked: %zu wrong\n", lex->n, bad);
+
+  for (gaddag = 1; gaddag >= 0; gaddag--)
+    {
+      uint32_t root = d->gaddag;
+
+      if (gaddag && !root)
+	continue;
+      if (!gaddag)
+	d->gaddag = 0;
+
+      t = Now();
+      for (i = 0; i < lex->n; i++)
+	DawgHooks(d, LexWord(lex, i), strlen(LexWord(lex, i)), &front, &back);
+      printf("  hooks %.2f us a word (%s)\n", 1e6 * (Now() - t) / lex->n,
+	     gaddag ? "GADDAG" : "DAWG");
+
+      for (j = 0; patterns[j]; j++)
+	{
+	  t = Now();
+	  for (runs = 0; runs == 0 || Now() - t < 0.2; runs++)
+	    {
+	      found = 0;
+	      DawgMatch(d, patterns[j], Count, &found);
+	    }
+	  printf("    %-6s %7zu words %10.1f us\n", patterns[j], found, 1e6 * (Now() - t) / runs);
+	}
+
+      d->gaddag = root;
+    }
+
+  /* Words the signatures can't count are never a rack's */
+  sigs = malloc(lex->n * sizeof(anagramSigType));
+  for (i = 0; i < lex->n; i++)
+    if (AnagramSig(LexWord(lex, i), strlen(LexWord(lex, i)), &sigs[i]) < 0)
+      sigs[i].s[0] = ~(UInt32) 0;
+  bad += TestRacks(lex, sigs, d, 7);
+  bad += TestRacks(lex, sigs, d, 8);
+  bad += TestRacks(lex, sigs, d, 15);
+  free(sigs);
+
+  return bad ? -1 : 0;
+}
+
+
+
+int main(int argc, char **argv)
+{
+  static lexType lex;
+  const char *name = "lflex", *in, *out;
+  char **words, **strings, *block, *gblock;
+  unsigned char *data;
+  size_t i, j, n, edges;
+  uint32_t dawgroot, gaddagroot = 0;
+  dawgBuildType b;
+  imageType img;
+  dawgType d;
+  int gaddag = 0, test = 0, c;
+  double start = Now();
+  FILE *f;
+
+  while ((c = getopt(argc, argv, "gtn:")) != -1)
+    switch (c)
+      {
+      case 'g':
+	gaddag = 1;
+	break;
+      case 't':
+	test = 1;
+	break;
+      case 'n':
+	name = optarg;
+	break;
+      default:
+	Usage();
+      }
+
+  if (argc - optind != 2 || strlen(name) > 31)
+    Usage();
+  in = argv[optind];
+  out = argv[optind + 1];
+
+  f = strcmp(in, "-") ? fopen(in, "r") : stdin;
+  if (!f)
+    {
+      perror(in);
+      return 1;
+    }
+  if (LexRead(f, in, &lex) < 0)
+    return 1;
+  if (f != stdin)
+    fclose(f);
+
+  /* The words as letter codes, sorted */
+  words = malloc(lex.n * sizeof(char *));
+  block = malloc(lex.size);
+  if (!words || !block)
+    {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  for (i = 0; i < lex.size; i++)
+    block[i] = lex.text[i] & 0x1F;
+  for (i = 0; i < lex.n; i++)
+    words[i] = block + lex.word[i];
+  qsort(words, lex.n, sizeof(char *), CompareStrings);
+
+  DawgBuildInit(&b);
+  if (DawgBuildAdd(&b, words, lex.n, &dawgroot) < 0)
+    return 1;
+  edges = b.n;
+
+  if (gaddag)
+    {
+      strings = Gaddag(&lex, &n, &gblock);
+      qsort(strings, n, sizeof(char *), CompareStrings);
+      if (DawgBuildAdd(&b, strings, n, &gaddagroot) < 0)
+	return 1;
+      free(gblock);
+      free(strings);
+    }
+
+  /* The header, then the edges */
+  ImageInit(&img, 0, 0);
+  data = calloc(DAWGHEADERSIZE, 1);
+  memcpy(data, "LFDW", 4);
+  Put32(data + 4, b.n);
+  Put32(data + 8, dawgroot);
+  Put32(data + 12, gaddagroot);
+  Put32(data + 16, lex.n);
+  Put16(data + 20, DAWGRECEDGES);
+  ImageAdd(&img, data, DAWGHEADERSIZE);
+
+  for (i = 0; i < b.n; i += DAWGRECEDGES)
+    {
+      n = (b.n - i < DAWGRECEDGES) ? b.n - i : DAWGRECEDGES;
+      data = malloc(4 * n);
+      for (j = 0; j < n; j++)
+	Put32(data + 4 * j, b.edge[i + j]);
+      ImageAdd(&img, data, 4 * n);
+    }
+
+  f = fopen(out, "wb");
+  if (!f)
+    {
+      perror(out);
+      return 1;
+    }
+  if (PdbWrite(f, name, "Dawg", DECKDBCREATOR, NULL, 0, &img) < 0 || fclose(f) != 0)
+    {
+      fprintf(stderr, "%s: write failed\n", out);
+      return 1;
+    }
+
+  printf("%s: %zu words, %zu DAWG edges", out, lex.n, edges - 1);
+  if (gaddag)
+    printf(" + %zu GADDAG edges", b.n - edges);
+  printf(", %zu bytes in %zu records, %.2f seconds\n", img.bytes, img.n, Now() - start);
+
+  if (test)
+    {
+      const UInt8 **recs = malloc(img.n * sizeof(UInt8 *));
+
+      if (!DawgInit(&d, img.rec[0].data, img.rec[0].size))
+	return 1;
+      for (i = 1; i < img.n; i++)
+	recs[i - 1] = img.rec[i].data;
+      d.rec = recs;
+      if (Test(&lex, &d) < 0)
+	return 1;
+      free(recs);
+    }
+
+  free(words);
+  free(block);
+  ImageFree(&img);
+  DawgBuildFree(&b);
+  LexFree(&lex);
+
+  return 0;
+}
@@ -0,0 +1,625 @@
+/* -----------------------------------------------------------------------------
+   mkdeck - compile flashcard PDBs from a word list.
+
+   Usage: mkdeck [-j threads] [-l min-max] [-n name] [-b] [-t] [-H] lexicon.txt outdir
+
+     -j threads    threads to use (default: one per core)
+     -l min-max    word lengths to make decks of (default 2-9, or 7-8
+                   with -b)
+     -n name       names the DBs "<name> 7s" and so on (default Anagrams,
+                   or Blanks with -b)
+     -b            make blank cards ("AEINRT?") instead
+     -t            write text records rather than binary ones (see card.h)
+     -H            leave the hooks out, for LAMPFlash to find in its
+                   lexicon (see tools/mkdawg.c) - quicker, and the text
+                   records are smaller
+
+   The lexicon is a word to a line in any order ("-" reads standard
+   input); anything after the word is ignored.  Every word of a length
+   asked for becomes an answer on the card for its alphagram, with the
+   letters that hook it on either side found in the whole lexicon.
+   Anagrams are told by their letter-count signatures (anagram.h), which
+   also sort words of one length into alphagram order, so a word with
+   more of one letter than a signature can count is left out.  Each
+   length gets a DB of its own, written to outdir as "<name>-7.pdb" (with
+   "-2", "-3" ... after it should one length need more than 65535 cards).
+
+   With -b a card is a rack of one letter fewer than its answers and a
+   blank, for every rack that makes a word with some letter for the
+   blank.  The racks are each word's signature less one of its letters,
+   with the repeats dropped, and a rack's answers are found by looking
+   up its signature with each of the 26 letters added in the anagram
+   index.  Each answer notes the letter the blank stands for.
+
+   Working out the alphagrams and hooks, sorting, and building the
+   records are each shared out between the threads: the words are cut
+   into chunks, the sort into buckets of one length and first letter,
+   and the records by length.  Each thread takes the next piece of work
+   there is until there is none.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <PalmOS.h>
+#include "lf.h"
+#include "card.h"
+#include "anagram.h"
+#include "dictbuild.h"
+#include "deckbuild.h"
+
+/* Words to a piece of work when working out alphagrams and hooks */
+#define CHUNKWORDS        4096
+
+/* Cards a DB can hold */
+#define DECKMAXCARDS      0xFFFF
+
+#define MAXTHREADS        256
+
+/* wordType - A word that goes on a card */
+typedef struct
+{
+  const char   *word;
+  anagramSigType sig;
+  uint32_t      front, back;
+  char          alpha[MAXWORDLENGTH + 1];
+} wordType;
+
+/* deckType - The cards of one length */
+typedef struct
+{
+  size_t        first, last;  /* Its words */
+  size_t        cards;
+  size_t        answers;
+  size_t        bytes;
+  int           dbs;
+  int           err;
+} deckType;
+
+/* jobsType - Pieces of work shared between threads */
+typedef struct
+{
+  size_t        next;      /* Next piece to be taken */
+  size_t        n;
+  void        (*fn)(void *ctx, size_t job);
+  void         *ctx;
+} jobsType;
+
+
+static const lexType *lex;
+static wordType *words;
+static size_t nwords;
+static size_t *bucket;     /* Start of each sort bucket in words */
+static int minlen = 2, maxlen = MAXWORDLENGTH;
+static const char *name, *outdir;
+static int text, nohooks, blanks;
+
+/* The anagram index of the lexicon, for -b, each letter's signature,
+   and the front and back hooks of each word of the lexicon */
+static anagramIndexType idx;
+static anagramSigType letter[26];
+static uint32_t (*lexhooks)[2];
+
+
+static void Usage(void)
+{
+  fprintf(stderr, "usage: mkdeck [-j threads] [-l min-max] [-n name] [-b] [-t] [-H] lexicon.txt outdir\n");
+  exit(2);
+}
+
+
+
+static void *Worker(void *arg)
+{
+  jobsType *jobs = arg;
+  size_t job;
+
+  while ((job = __atomic_fetch_add(&jobs->next, 1, __ATOMIC_RELAXED)) < jobs->n)
+    jobs->fn(jobs->ctx, job);
+
+  return NULL;
+}
+
+
+
+/* Do the n jobs fn(ctx, 0) to fn(ctx, n - 1) with nthreads threads */
+static void Parallel(int nthreads, size_t n, void (*fn)(void *, size_t), void *ctx)
+{
+  pthread_t thread[MAXTHREADS];
+  jobsType jobs = { 0, n, fn, ctx };
+  int i;
+
+  for (i = 1; i < nthreads; i++)
+    if (pthread_create(&thread[i], NULL, Worker, &jobs) != 0)
+      break;
+
+  Worker(&jobs);
+  while (--i > 0)
+    pthread_join(thread[i], NULL);
+}
+
+
+
+/* The alphagrams and hooks of a chunk of words */
+static void HookChunk(void *ctx, size_t job)
+{
+  size_t i, last = (job + 1) * CHUNKWORDS, len;
+  wordType *w;
+
+  if (last > nwords)
+    last = nwords;
+
+  for (i = job * CHUNKWORDS; i < last; i++)
+    {
+      w = &words[i];
+      len = strlen(w->word);
+      Alphagram(w->word, len, w->alpha);
+      if (nohooks)
+	w->front = w->back = 0;
+      else
+	LexHooks(lex, w->word, len, &w->front, &w->back);
+    }
+}
+
+
+
+/* The hooks of a chunk of the lexicon's words, for -b.  Only words of
+   the lengths asked for are ever answers. */
+static void LexHookChunk(void *ctx, size_t job)
+{
+  size_t i, last = (job + 1) * CHUNKWORDS, len;
+
+  if (last > lex->n)
+    last = lex->n;
+
+  for (i = job * CHUNKWORDS; i < last; i++)
+    {
+      len = strlen(LexWord(lex, i));
+      if (len >= minlen && len <= maxlen)
+	LexHooks(lex, LexWord(lex, i), len, &lexhooks[i][0], &lexhooks[i][1]);
+    }
+}
+
+
+
+static int Compare(const void *a, const void *b)
+{
+  const wordType *x = a, *y = b;
+  int c = AnagramCompare(&x->sig, &y->sig);
+
+  return c ? c : strcmp(x->word, y->word);
+}
+
+
+
+/* Buckets are one length and first letter of alphagram, in order */
+static size_t Bucket(const wordType *w)
+{
+  return (strlen(w->word) - minlen) * 26 + (w->alpha[0] - 'A');
+}
+
+
+
+static void SortBucket(void *ctx, size_t job)
+{
+  qsort(words + bucket[job], bucket[job + 1] - bucket[job], sizeof(wordType), Compare);
+}
+
+
+
+/* Work out the alphagrams and hooks of the words of the lengths asked
+   for, and sort them into alphagram order in words, with each deck's
+   first and last set.  Returns 0, or -1 if out of memory. */
+static int SortWords(int nthreads, deckType *deck)
+{
+  size_t i, b, nbuckets, len, nosig = 0;
+  size_t *count;
+  wordType *sorted;
+
+  /* The words that go on cards */
+  words = malloc(lex->n * sizeof(wordType));
+  sorted = malloc(lex->n * sizeof(wordType));
+  nbuckets = (maxlen - minlen + 1) * 26;
+  count = calloc(nbuckets + 1, sizeof(size_t));
+  bucket = calloc(nbuckets + 1, sizeof(size_t));
+  if (!words || !sorted || !count || !bucket)
+    {
+      fprintf(stderr, "out of memory\n");
+      return -1;
+    }
+
+  for (i = 0; i < lex->n; i++)
+    {
+      len = strlen(LexWord(lex, i));
+      if (len < minlen || len > maxlen)
+	continue;
+
+      if (AnagramSig(LexWord(lex, i), len, &words[nwords].sig) != 0)
+	nosig++;
+      else
+	words[nwords++].word = LexWord(lex, i);
+    }
+  if (nosig)
+    printf("%zu words with more than %d of a letter left out\n", nosig,
+	   ANAGRAMMAXCOUNT);
+
+  Parallel(nthreads, (nwords + CHUNKWORDS - 1) / CHUNKWORDS, HookChunk, NULL);
+
+  /* Deal the words into their buckets, then sort each one */
+  for (i = 0; i < nwords; i++)
+    count[Bucket(&words[i])]++;
+  for (b = 0; b < nbuckets; b++)
+    bucket[b + 1] = bucket[b] + count[b];
+  memset(count, 0, nbuckets * sizeof(size_t));
+  for (i = 0; i < nwords; i++)
+    {
+      b = Bucket(&words[i]);
+      sorted[bucket[b] + count[b]++] = words[i];
+    }
+  free(words);
+  words = sorted;
+
+  Parallel(nthreads, nbuckets, SortBucket, NULL);
+
+  for (len = minlen; len <= maxlen; len++)
+    {
+      deck[len - minlen].first = bucket[(len - minlen) * 26];
+      deck[len - minlen].last = bucket[(len - minlen + 1) * 26];
+    }
+  free(count);
+
+  return 0;
+}
+
+
+
+/* Write the cards of one image as DB part (0 if it's the only one) */
+static int WriteDeck(int len, int part, const imageType *img)
+{
+  char path[4096], dbname[MAXDBTITLE];
+  FILE *f;
+
+  if (part)
+    {
+      snprintf(path, sizeof(path), "%s/%s-%d-%d.pdb", outdir, name, len, part);
+      snprintf(dbname, sizeof(dbname), "%s %ds %d", name, len, part);
+    }
+  else
+    {
+      snprintf(path, sizeof(path), "%s/%s-%d.pdb", outdir, name, len);
+      snprintf(dbname, sizeof(dbname), "%s %ds", name, len);
+    }
+
+  f = fopen(path, "wb");
+  if (!f)
+    {
+      perror(path);
+      return -1;
+    }
+  if (PdbWrite(f, dbname, DECKDBTYPE, DECKDBCREATOR, NULL, 0, img) < 0
+      || fclose(f) != 0)
+    {
+      fprintf(stderr, "%s: write failed\n", path);
+      return -1;
+    }
+
+  return 0;
+}
+
+
+
+/* Room in *a for n answers */
+static deckAnswerType *AnswerRoom(deckAnswerType **a, size_t *cap, size_t n)
+{
+  if (n > *cap)
+    {
+      *cap = 2 * n;
+      *a = realloc(*a, *cap * sizeof(deckAnswerType));
+      if (!*a)
+	{
+	  fprintf(stderr, "out of memory\n");
+	  exit(1);
+	}
+    }
+
+  return *a;
+}
+
+
+
+/* Add the card asking question with the n answers a to img, writing
+   img out first if it's full */
+static void PutCard(deckType *deck, int len, imageType *img, const char *question,
+		    const deckAnswerType *a, size_t n)
+{
+  unsigned char *rec;
+  size_t size;
+
+  rec = text ? CardText(question, a, n, 1, &size) : CardBinary(question, a, n, &size);
+  if (!rec)
+    {
+      fprintf(stderr, "card %s is over 64K\n", question);
+      deck->err = 1;
+      return;
+    }
+
+  if (img->n == DECKMAXCARDS)
+    {
+      deck->err = WriteDeck(len, ++deck->dbs, img) < 0;
+      ImageFree(img);
+    }
+  ImageAdd(img, rec, size);
+  deck->cards++;
+  deck->answers += n;
+  deck->bytes += size;
+}
+
+
+
+/* Write what's left of img.  Only a length that had to be split has
+   its DBs numbered. */
+static void EndDeck(deckType *deck, int len, imageType *img)
+{
+  if (!deck->err && img->n > 0)
+    {
+      deck->err = WriteDeck(len, deck->dbs ? deck->dbs + 1 : 0, img) < 0;
+      deck->dbs++;
+    }
+  ImageFree(img);
+}
+
+
+
+/* Make and write the cards of the words of one length */
+static void BuildDeck(void *ctx, size_t job)
+{
+  deckType *deck = (deckType *) ctx + job;
+  deckAnswerType *a = NULL;
+  imageType img;
+  size_t i, j, n, cap = 0;
+  int len = minlen + job;
+
+  ImageInit(&img, 0, 0);
+
+  for (i = deck->first; i < deck->last && !deck->err; i = j)
+    {
+      /* An alphagram's words are next to each other */
+      for (j = i, n = 0; j < deck->last && AnagramEqual(&words[j].sig, &words[i].sig); j++, n++)
+	{
+	  AnswerRoom(&a, &cap, n + 1);
+	  a[n].word = words[j].word;
+	  a[n].front = words[j].front;
+	  a[n].back = words[j].back;
+	  a[n].blank = 0;
+	}
+
+      PutCard(deck, len, &img, words[i].alpha, a, n);
+    }
+
+  EndDeck(deck, len, &img);
+  free(a);
+}
+
+
+
+static int CompareSig(const void *a, const void *b)
+{
+  return AnagramCompare(a, b);
+}
+
+
+
+static int CompareAnswer(const void *a, const void *b)
+{
+  return strcmp(((const deckAnswerType *) a)->word, ((const deckAnswerType *) b)->word);
+}
+
+
+
+/* Make and write the blank cards whose answers are one length */
+static void BuildBlankDeck(void *ctx, size_t job)
+{
+  deckType *deck = (deckType *) ctx + job;
+  deckAnswerType *a = NULL;
+  anagramSigType *racks, sig;
+  imageType img;
+  char question[MAXWORDLENGTH + 1];
+  size_t g, r, n, nracks, i, cap = 0, first = idx.bylen[minlen + job];
+  size_t last = idx.bylen[minlen + job + 1];
+  long found;
+  int len = minlen + job, c, k;
+
+  ImageInit(&img, 0, 0);
+
+  /* Every group less each of its letters, in order and once each */
+  racks = malloc(((last - first) * 26 + 1) * sizeof(anagramSigType));
+  if (!racks)
+    {
+      fprintf(stderr, "out of memory\n");
+      exit(1);
+    }
+  for (g = first, nracks = 0; g < last; g++)
+    for (c = 0; c < 26; c++)
+      if (AnagramHolds(&idx.sig[g], &letter[c], 0))
+	{
+	  racks[nracks] = idx.sig[g];
+	  AnagramTake(&racks[nracks++], &letter[c]);
+	}
+  qsort(racks, nracks, sizeof(anagramSigType), CompareSig);
+
+  for (r = 0; r < nracks && !deck->err; r++)
+    {
+      if (r > 0 && AnagramEqual(&racks[r], &racks[r - 1]))
+	continue;
+
+      /* The blank as each letter in turn.  A count of seven goes over
+	 into its guard bit, which no word's signature has. */
+      for (c = 0, n = 0; c < 26; c++)
+	{
+	  for (k = 0; k < 4; k++)
+	    sig.s[k] = racks[r].s[k] + letter[c].s[k];
+	  found = AnagramIndexFind(&idx, &sig);
+	  if (found < 0)
+	    continue;
+
+	  for (i = idx.first[found]; i < idx.first[found + 1]; i++, n++)
+	    {
+	      AnswerRoom(&a, &cap, n + 1);
+	      a[n].word = LexWord(lex, idx.word[i]);
+	      a[n].blank = 'A' + c;
+	      a[n].front = lexhooks ? lexhooks[idx.word[i]][0] : 0;
+	      a[n].back = lexhooks ? lexhooks[idx.word[i]][1] : 0;
+	    }
+	}
+      qsort(a, n, sizeof(deckAnswerType), CompareAnswer);
+
+      AnagramAlphagram(&racks[r], question);
+      strcat(question, "?");
+      PutCard(deck, len, &img, question, a, n);
+    }
+
+  EndDeck(deck, len, &img);
+  free(racks);
+  free(a);
+}
+
+
+
+int main(int argc, char **argv)
+{
+  static lexType lexicon;
+  deckType deck[MAXWORDLENGTH + 1];
+  size_t len;
+  int nthreads = sysconf(_SC_NPROCESSORS_ONLN), c, err = 0, lengths = 0;
+  double start = Now(), t;
+  FILE *f;
+
+  while ((c = getopt(argc, argv, "j:l:n:btH")) != -1)
+    switch (c)
+      {
+      case 'j':
+	nthreads = atoi(optarg);
+	break;
+      case 'l':
+	if (sscanf(optarg, "%d-%d", &minlen, &maxlen) != 2)
+	  Usage();
+	lengths = 1;
+	break;
+      case 'n':
+	name = optarg;
+	break;
+      case 'b':
+	blanks = 1;
+	break;
+      case 't':
+	text = 1;
+	break;
+      case 'H':
+	nohooks = 1;
+	break;
+      default:
+	Usage();
+      }
+
+  if (!name)
+    name = blanks ? "Blanks" : "Anagrams";
+  if (blanks && !lengths)
+    {
+      minlen = 7;
+      maxlen = 8;
+    }
+
+  /* Room is left in the DB name for " 9s 2" */
+  if (argc - optind != 2 || minlen < 1 + blanks || maxlen > MAXWORDLENGTH || minlen > maxlen
+      || strlen(name) > MAXDBTITLE - 1 - 6)
+    Usage();
+  if (nthreads < 1)
+    nthreads = 1;
+  if (nthreads > MAXTHREADS)
+    nthreads = MAXTHREADS;
+  outdir = argv[optind + 1];
+
+  f = strcmp(argv[optind], "-") ? fopen(argv[optind], "r") : stdin;
+  if (!f)
+    {
+      perror(argv[optind]);
+      return 1;
+    }
+  if (LexRead(f, argv[optind], &lexicon) < 0)
+    return 1;
+  if (f != stdin)
+    fclose(f);
+  lex = &lexicon;
+  t = Now();
+  printf("%zu words read in %.2f seconds", lex->n, t - start);
+  if (lex->repeats)
+    printf(", %zu repeated", lex->repeats);
+  if (lex->skipped)
+    printf(", %zu lines skipped", lex->skipped);
+  printf("\n");
+
+  memset(deck, 0, sizeof(deck));
+
+  if (blanks)
+    {
+      if (AnagramIndexBuild(lex, &idx) < 0)
+	return 1;
+      for (c = 0; c < 26; c++)
+	{
+	  char l = 'A' + c;
+
+	  AnagramSig(&l, 1, &letter[c]);
+	}
+
+      /* Each word's hooks are worked out once here, rather than once
+	 for every rack it's an answer to */
+      if (!nohooks)
+	{
+	  lexhooks = calloc(lex->n, sizeof(*lexhooks));
+	  if (!lexhooks)
+	    {
+	      fprintf(stderr, "out of memory\n");
+	      return 1;
+	    }
+	  Parallel(nthreads, (lex->n + CHUNKWORDS - 1) / CHUNKWORDS, LexHookChunk, NULL);
+	}
+      printf("%zu words indexed%s in %.2f seconds\n", idx.words,
+	     nohooks ? "" : " and hooked", Now() - t);
+      t = Now();
+
+      Parallel(nthreads, maxlen - minlen + 1, BuildBlankDeck, deck);
+      AnagramIndexFree(&idx);
+      free(lexhooks);
+    }
+  else
+    {
+      if (SortWords(nthreads, deck) < 0)
+	return 1;
+      printf("%zu words hooked and sorted in %.2f seconds\n", nwords, Now() - t);
+      t = Now();
+
+      Parallel(nthreads, maxlen - minlen + 1, BuildDeck, deck);
+    }
+
+  for (len = minlen; len <= maxlen; len++)
+    {
+      deckType *d = &deck[len - minlen];
+
+      if (d->err)
+	err = 1;
+      else if (d->cards)
+	printf("  %zus: %zu cards of %zu answers, %zu bytes in %d DB%s\n", len, d->cards,
+	       d->answers, d->bytes, d->dbs, d->dbs == 1 ? "" : "s");
+    }
+  printf("%s records written in %.2f seconds, %.2f seconds in all with %d thread%s\n",
+	 text ? "text" : "binary", Now() - t, Now() - start, nthreads,
+	 nthreads == 1 ? "" : "s");
+
+  free(words);
+  free(bucket);
+  LexFree(&lexicon);
+
+  return err;
+}
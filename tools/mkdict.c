@@ -0,0 +1,156 @@
+/* -----------------------------------------------------------------------------
+   mkdict - compile the lfdict dictionary PDB from its text source.
+
+   Usage: mkdict [-p] [-r bytes] [-m megabytes] [-n name] [-x xref.pdb]
+                 source.txt lfdict.pdb
+
+     -p            pack the records (front-coded words, byte-pair coded
+                   definitions) - see dictrec.h
+     -r bytes      unpacked bytes of entries per record (default 16384)
+     -m megabytes  memory to sort in before using temporary files
+                   (default 64)
+     -n name       name of the database on the Palm (default lfdict)
+     -x xref.pdb   also write the cross-reference DB ("<name>-xref" on
+                   the Palm) - see dictxref.h
+
+   The source is one "word<TAB>definition" entry to a line in any order
+   ("-" reads standard input).  It is sorted - in the order the Palm
+   compares words in - with repeated words dropped, and cut into records
+   without splitting an entry.  The first word of each record goes in
+   the app info block so the Palm doesn't have to build the index.
+   ----------------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <PalmOS.h>
+#include "dictrec.h"
+#include "dictbuild.h"
+#include "dictsort.h"
+#include "dictxref.h"
+
+
+static void Usage(void)
+{
+  fprintf(stderr, "usage: mkdict [-p] [-r bytes] [-m megabytes] [-n name] [-x xref.pdb]\n"
+	  "              source.txt lfdict.pdb\n");
+  exit(2);
+}
+
+
+
+/* Each entry out of the sort goes into the records */
+static int Entry(void *ctx, const char *word, const char *def)
+{
+  return ImageEntry(ctx, word, def);
+}
+
+
+
+int main(int argc, char **argv)
+{
+  const char *name = "lfdict", *in, *out, *xrefout = NULL;
+  char xrefname[32];
+  size_t recsize = DICTRECSIZE, budget = SORTBUDGET, indexsize = 0, refs = 0;
+  unsigned char *index;
+  int packed = 0, c;
+  sortStatsType stats;
+  imageType img, xref;
+  double start = Now();
+  FILE *f;
+
+  while ((c = getopt(argc, argv, "pr:m:n:x:")) != -1)
+    switch (c)
+      {
+      case 'p':
+	packed = 1;
+	break;
+      case 'r':
+	recsize = strtoul(optarg, NULL, 0);
+	break;
+      case 'm':
+	budget = strtoul(optarg, NULL, 0) << 20;
+	break;
+      case 'n':
+	name = optarg;
+	break;
+      case 'x':
+	xrefout = optarg;
+	break;
+      default:
+	Usage();
+      }
+
+  if (argc - optind != 2 || recsize == 0 || budget == 0 || strlen(name) > 31
+      || (xrefout && strlen(name) > 31 - 5))
+    Usage();
+  in = argv[optind];
+  out = argv[optind + 1];
+
+  f = strcmp(in, "-") ? fopen(in, "r") : stdin;
+  if (!f)
+    {
+      perror(in);
+      return 1;
+    }
+
+  ImageInit(&img, packed, recsize);
+  if (SortSource(f, in, budget, Entry, &img, &stats) < 0 || ImageFinish(&img) < 0)
+    return 1;
+  if (f != stdin)
+    fclose(f);
+
+  index = ImageIndex(&img, name, &indexsize);
+  if (!index)
+    fprintf(stderr, "warning: first words are over 64K - the Palm will read the records\n");
+
+  f = fopen(out, "wb");
+  if (!f)
+    {
+      perror(out);
+      return 1;
+    }
+  if (PdbWrite(f, name, DICTDBTYPE, DICTDBCREATOR, index, indexsize, &img) < 0
+      || fclose(f) != 0)
+    {
+      fprintf(stderr, "%s: write failed\n", out);
+      return 1;
+    }
+
+  if (xrefout)
+    {
+      snprintf(xrefname, sizeof(xrefname), "%s-xref", name);
+      f = fopen(xrefout, "wb");
+      if (!f)
+	{
+	  perror(xrefout);
+	  return 1;
+	}
+      if (XrefBuild(&img, &xref, &refs) < 0
+	  || PdbWrite(f, xrefname, DICTXREFDBTYPE, DICTDBCREATOR, NULL, 0, &xref) < 0
+	  || fclose(f) != 0)
+	{
+	  fprintf(stderr, "%s: write failed\n", xrefout);
+	  return 1;
+	}
+      ImageFree(&xref);
+    }
+
+  printf("%s: %zu words in %zu %s records, %zu bytes, index %zu bytes\n", out,
+	 stats.entries - stats.repeats, img.n, packed ? "packed" : "plain",
+	 img.bytes, indexsize);
+  if (stats.repeats)
+    printf("  %zu repeated words dropped\n", stats.repeats);
+  printf("  sorted in %s", stats.runs ? "" : "memory");
+  if (stats.runs)
+    printf("%zu runs", stats.runs);
+  if (xrefout)
+    printf(", %zu cross-references", refs);
+  printf(", %.2f seconds\n", Now() - start);
+
+  free(index);
+  ImageFree(&img);
+
+  return 0;
+}